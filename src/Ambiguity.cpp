@@ -6,6 +6,7 @@
 Ambiguity::AmbigBimap Ambiguity::abm;//  = AmbigMap();
 Ambiguity::AmbigIDBimap Ambiguity::ids;//  = AmbigIDMap();
 int Ambiguity::nextID = -1;
+Ambiguity::AmbigJournal * Ambiguity::journal = 0;
 
 void
 Ambiguity::addIDs(Motus_Tag_ID proxyID, AmbigIDs newids) {
@@ -126,6 +127,8 @@ Ambiguity::newProxy(AmbigTags & tags, Tag * t) {
     proxyID = nextID--;
     ids.insert(AmbigIDSetProxy(tmpids, proxyID));
   };
+  if (journal)
+    journal->push_back(std::make_pair(tmpids, proxyID));
 
   Tag * nt = new Tag();
   *nt = *t;
@@ -74,6 +74,10 @@ public:
   static int nextID;               //!< (negative) motus_Tag_ID for next proxy created; starts at -1, decremented for each new proxy;
                                    //!these ID value are only valid within a (possibly resumed) session of the tag finder
 
+  typedef std::vector < std::pair < AmbigIDs, Motus_Tag_ID > > AmbigJournal;
+  static AmbigJournal * journal;   //!< if not 0, newProxy appends the IDs and proxyID of each proxy it creates, so that
+                                   //!a saved graph's proxies can be given the IDs another receiver would use
+
   // methods
 
   static void addIDs(Motus_Tag_ID proxyID, AmbigIDs newids);    //!< record proxyID as representing the IDs in ids
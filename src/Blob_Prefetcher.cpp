@@ -0,0 +1,170 @@
+#include "Blob_Prefetcher.hpp"
+#include "DB_Filer.hpp"
+
+#include <algorithm>
+
+Blob_Prefetcher::Blob_Prefetcher(const std::string & db_path, const std::vector < File > & files, int depth) :
+  files(files),
+  depth(depth),
+  slots(depth + 1),
+  conns(),
+  stmts(),
+  workers(),
+  next(0),
+  started(false),
+  stopping(false),
+  generation(0),
+  error()
+{
+  // There is one more slot than there are files being read ahead,
+  // because the slot of the file most recently handed out stays in use
+  // until the next call to get().
+
+  for (auto s = slots.begin(); s != slots.end(); ++s) {
+    s->state = Slot::EMPTY;
+    s->index = 0;
+    s->null = false;
+  }
+
+  // Connections and statements are set up here, rather than by the
+  // workers, so that any schema lookup happens before we compete with
+  // the main connection's transactions; readfile2() itself doesn't
+  // touch the database.
+
+  for (int w = 0; w < depth; ++w) {
+    sqlite3 * db;
+    if (sqlite3_open_v2(db_path.c_str(), & db, SQLITE_OPEN_READONLY, 0) != SQLITE_OK) {
+      sqlite3_close(db);
+      throw std::runtime_error("Unable to open receiver database read-only for prefetching files");
+    }
+    conns.push_back(db);
+    sqlite3_busy_timeout(db, 60000);
+    if (! DB_Filer::load_extension(db))
+      throw std::runtime_error("Unable to load Sqlite_Compression_Extension.so from folder with `find_tags_motus`");
+    sqlite3_stmt * st;
+    if (sqlite3_prepare_v2(db, "select readfile2(?, ?)", -1, & st, 0) != SQLITE_OK)
+      throw std::runtime_error(std::string("Unable to prepare query for prefetching files\nSqlite error: ") + sqlite3_errmsg(db));
+    stmts.push_back(st);
+  }
+  for (int w = 0; w < depth; ++w)
+    workers.push_back(std::thread(& Blob_Prefetcher::work, this, w));
+};
+
+Blob_Prefetcher::~Blob_Prefetcher() {
+  {
+    std::lock_guard < std::mutex > lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto t = workers.begin(); t != workers.end(); ++t)
+    t->join();
+  for (auto s = stmts.begin(); s != stmts.end(); ++s)
+    sqlite3_finalize(*s);
+  for (auto c = conns.begin(); c != conns.end(); ++c)
+    sqlite3_close(*c);
+};
+
+void
+Blob_Prefetcher::seek(Timestamp tsseek) {
+  std::lock_guard < std::mutex > lock(mtx);
+  next = std::lower_bound(files.begin(), files.end(), tsseek,
+                          [](const File & f, Timestamp ts) {
+                            return f.ts < ts;
+                          }) - files.begin();
+  // drop everything; any file being read is discarded by its worker
+  for (auto s = slots.begin(); s != slots.end(); ++s)
+    s->state = Slot::EMPTY;
+  ++generation;
+  started = true;
+  cv.notify_all();
+};
+
+bool
+Blob_Prefetcher::claim(size_t & i) {
+  if (! started)
+    return false;
+  size_t end = std::min(next + depth, files.size());
+  for (i = next; i < end; ++i)
+    if (slots[i % slots.size()].state == Slot::EMPTY)
+      return true;
+  return false;
+};
+
+void
+Blob_Prefetcher::work(int w) {
+  sqlite3_stmt * st = stmts[w];
+  std::unique_lock < std::mutex > lock(mtx);
+  for (;;) {
+    size_t i;
+    cv.wait(lock, [&] {return stopping || claim(i);});
+    if (stopping)
+      return;
+    Slot & s = slots[i % slots.size()];
+    s.state = Slot::READING;
+    s.index = i;
+    unsigned gen = generation;
+    const File & f = files[i];
+    lock.unlock();
+
+    // read and decompress the file; a null result (e.g. a missing or
+    // corrupt file) is handed out as an empty blob
+
+    std::string data;
+    bool null = true;
+    std::string err;
+    sqlite3_bind_text(st, 1, f.path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(st, 2, f.compressed);
+    int res = sqlite3_step(st);
+    if (res == SQLITE_ROW) {
+      const char * blob = reinterpret_cast < const char * > (sqlite3_column_blob(st, 0));
+      if (blob) {
+        data.assign(blob, sqlite3_column_bytes(st, 0));
+        null = false;
+      }
+    } else {
+      err = std::string("Problem getting next blob.\nSqlite error: ") + sqlite3_errmsg(conns[w]);
+    }
+    sqlite3_reset(st);
+
+    lock.lock();
+    if (err.length() > 0 && error.length() == 0)
+      error = err;
+    if (gen == generation) {
+      s.data.swap(data);
+      s.null = null;
+      s.state = Slot::READY;
+    }
+    cv.notify_all();
+  }
+};
+
+bool
+Blob_Prefetcher::get(const char ** bufout, int * lenout, Timestamp * ts, int * fileID) {
+  std::unique_lock < std::mutex > lock(mtx);
+  started = true;
+
+  // the caller is done with the previous file, so its slot can be re-used
+  if (next > 0) {
+    Slot & prev = slots[(next - 1) % slots.size()];
+    if (prev.state == Slot::READY && prev.index == next - 1) {
+      prev.state = Slot::EMPTY;
+      prev.data = std::string();
+    }
+  }
+  cv.notify_all();
+
+  if (next >= files.size())
+    return false;
+
+  Slot & s = slots[next % slots.size()];
+  cv.wait(lock, [&] {return error.length() > 0 || (s.state == Slot::READY && s.index == next);});
+  if (error.length() > 0)
+    throw std::runtime_error(error);
+
+  * bufout = s.null ? 0 : s.data.data();
+  * lenout = s.null ? 0 : s.data.length();
+  * ts = files[next].ts;
+  * fileID = files[next].fileID;
+  ++next;
+  return true;
+};
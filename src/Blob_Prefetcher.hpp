@@ -0,0 +1,73 @@
+#ifndef BLOB_PREFETCHER_HPP
+#define BLOB_PREFETCHER_HPP
+
+#include "find_tags_common.hpp"
+
+#include <sqlite3.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+  Blob_Prefetcher - read and decompress raw receiver files on worker
+  threads, ahead of their use by the tag finder.
+
+  The files are given as a manifest, sorted by timestamp.  Each worker
+  has its own read-only connection to the receiver database, and gets
+  file contents by calling the `readfile2` extension function, just as
+  DB_Filer::q_get_blob does.  Up to `depth` files following the one
+  most recently handed out are read in advance; files are handed out
+  in manifest order.
+*/
+
+class Blob_Prefetcher {
+
+public:
+
+  //!< an entry in the manifest of files
+  struct File {
+    int fileID;       //!< ID of file in receiver DB `files` table
+    Timestamp ts;     //!< file timestamp
+    std::string path; //!< full path to file
+    int compressed;   //!< non-zero if file is compressed
+  };
+
+  Blob_Prefetcher(const std::string & db_path, const std::vector < File > & files, int depth); //!< start `depth` workers reading files from the manifest `files`
+  ~Blob_Prefetcher(); //!< stop workers, waiting for any files they're reading
+
+  void seek(Timestamp tsseek); //!< make the first file with timestamp >= tsseek the next one handed out
+
+  bool get(const char ** bufout, int * lenout, Timestamp * ts, int * fileID); //!< wait for contents of the next file, and return true; return false if none remain.  Contents remain valid until the next call to get() or seek().  If the file was unreadable, bufout is set to 0 and lenout to 0.
+
+protected:
+
+  //!< buffer for the contents of one file
+  struct Slot {
+    enum State {EMPTY, READING, READY};
+    State state;      //!< what's in this slot
+    size_t index;     //!< index in manifest of file being read into this slot
+    bool null;        //!< true if the file could not be read
+    std::string data; //!< file contents
+  };
+
+  std::vector < File > files; //!< the manifest
+  int depth; //!< number of files to read ahead
+  std::vector < Slot > slots; //!< file contents; file i is read into slots[i % slots.size()]
+  std::vector < sqlite3 * > conns; //!< one connection per worker
+  std::vector < sqlite3_stmt * > stmts; //!< one `readfile2` statement per worker
+  std::vector < std::thread > workers; //!< the worker threads
+
+  std::mutex mtx; //!< protects all members below, and slots
+  std::condition_variable cv; //!< signalled whenever a slot changes state, or reading starts or stops
+  size_t next; //!< index in manifest of next file to hand out
+  bool started; //!< false until first call to get() or seek(); no files are read before then
+  bool stopping; //!< true when workers must quit
+  unsigned generation; //!< incremented by seek(), so that workers discard files they were reading for an earlier position
+  std::string error; //!< message from first worker error; re-thrown by get()
+
+  void work(int w); //!< body of worker thread w
+  bool claim(size_t & i); //!< find the next file to read, if any; mtx must be held
+
+};
+
+#endif // BLOB_PREFETCHER_HPP
@@ -1,6 +1,8 @@
 #ifndef BOUNDED_RANGE_HPP
 #define BOUNDED_RANGE_HPP
 
+#include <limits>
+
 template < class VALTYPE > class  Bounded_Range {
 
   // class template for bounded ranges VALTYPE must be an ordered
@@ -68,6 +70,19 @@ public:
     return (! have_bounds) || (high - p <= width && p - low <= width);
   };
 
+  void get_compatible_limits (VALTYPE & lo, VALTYPE & hi, VALTYPE & w) {
+    // get lo, hi and w such that, for p other than NaN,
+    // is_compatible(p) == (hi - p <= w && p - lo <= w)
+    if (have_bounds) {
+      lo = low;
+      hi = high;
+      w = width;
+    } else {
+      lo = hi = 0;
+      w = std::numeric_limits < VALTYPE > :: infinity();
+    }
+  };
+
   void clear_bounds() {
     have_bounds = false;
   };
@@ -0,0 +1,328 @@
+#include "Cand_List.hpp"
+
+#include <algorithm>
+#include <limits>
+
+const Cand_List::Profile Cand_List::UNFILTERED = {
+  0,
+  - std::numeric_limits < Gap > :: infinity(),
+  0, 0, std::numeric_limits < double > :: infinity(),
+  0, 0, std::numeric_limits < float > :: infinity()
+};
+
+void
+Cand_List::Profile_Columns::push_back(const Profile & pr) {
+  last_ts.push_back(pr.last_ts);
+  max_age.push_back(pr.max_age);
+  f_low.push_back(pr.f_low);
+  f_high.push_back(pr.f_high);
+  f_width.push_back(pr.f_width);
+  s_low.push_back(pr.s_low);
+  s_high.push_back(pr.s_high);
+  s_width.push_back(pr.s_width);
+};
+
+void
+Cand_List::Profile_Columns::insert(size_t i, const Profile & pr) {
+  last_ts.insert(last_ts.begin() + i, pr.last_ts);
+  max_age.insert(max_age.begin() + i, pr.max_age);
+  f_low.insert(f_low.begin() + i, pr.f_low);
+  f_high.insert(f_high.begin() + i, pr.f_high);
+  f_width.insert(f_width.begin() + i, pr.f_width);
+  s_low.insert(s_low.begin() + i, pr.s_low);
+  s_high.insert(s_high.begin() + i, pr.s_high);
+  s_width.insert(s_width.begin() + i, pr.s_width);
+};
+
+void
+Cand_List::Profile_Columns::set(size_t i, const Profile & pr) {
+  last_ts[i] = pr.last_ts;
+  max_age[i] = pr.max_age;
+  f_low[i] = pr.f_low;
+  f_high[i] = pr.f_high;
+  f_width[i] = pr.f_width;
+  s_low[i] = pr.s_low;
+  s_high[i] = pr.s_high;
+  s_width[i] = pr.s_width;
+};
+
+void
+Cand_List::Profile_Columns::move(size_t from, size_t to) {
+  last_ts[to] = last_ts[from];
+  max_age[to] = max_age[from];
+  f_low[to] = f_low[from];
+  f_high[to] = f_high[from];
+  f_width[to] = f_width[from];
+  s_low[to] = s_low[from];
+  s_high[to] = s_high[from];
+  s_width[to] = s_width[from];
+};
+
+void
+Cand_List::Profile_Columns::resize(size_t n) {
+  last_ts.resize(n);
+  max_age.resize(n);
+  f_low.resize(n);
+  f_high.resize(n);
+  f_width.resize(n);
+  s_low.resize(n);
+  s_high.resize(n);
+  s_width.resize(n);
+};
+
+Cand_List::Cand_List() :
+  profiler(0),
+  ready(),
+  ready_pr(),
+  slots(),
+  overflow(),
+  horizon(- std::numeric_limits < Timestamp > :: infinity()),
+  overflow_min(std::numeric_limits < Timestamp > :: infinity()),
+  next_seq(0),
+  num_live(0),
+  num_removed(0)
+{
+};
+
+void
+Cand_List::set_profiler(Profiler p) {
+  profiler = p;
+};
+
+unsigned long long
+Cand_List::insert(Timestamp key, Tag_Candidate * tc) {
+  Entry e = {key, next_seq++, tc};
+  ++num_live;
+  if (key > horizon) {
+    add_future(e);
+  } else {
+    Profile pr;
+    get_profile(tc, pr);
+    if (ready.empty() || key >= ready.back().key) {
+      ready.push_back(e);
+      ready_pr.push_back(pr);
+    } else {
+      // e has the largest seq, so it goes after any entries with the same key
+      auto i = std::upper_bound(ready.begin(), ready.end(), e, before);
+      ready_pr.insert(i - ready.begin(), pr);
+      ready.insert(i, e);
+    }
+  }
+  return e.seq;
+};
+
+void
+Cand_List::add_future(const Entry & e) {
+  if (e.key < horizon + SPAN) {
+    if (slots.empty())
+      slots.resize(NUM_SLOTS);
+    slots[slot_num(e.key) & (NUM_SLOTS - 1)].push_back(e);
+  } else {
+    overflow.push_back(e);
+    if (e.key < overflow_min)
+      overflow_min = e.key;
+  }
+};
+
+void
+Cand_List::advance(Timestamp t) {
+  if (t <= horizon)
+    return;
+
+  static std::vector < Entry > arriving; // entries becoming ready, in no particular order
+  arriving.clear();
+
+  // move entries with key <= t from the slots covering (horizon, t]
+  if (! slots.empty()) {
+    long long s = std::isfinite(horizon) ? slot_num(horizon) : 0;
+    long long n = std::isfinite(horizon) ? slot_num(t) - s + 1 : NUM_SLOTS;
+    if (n > NUM_SLOTS)
+      n = NUM_SLOTS;
+    for (long long j = 0; j < n; ++j) {
+      auto & slot = slots[(s + j) & (NUM_SLOTS - 1)];
+      for (size_t k = 0; k < slot.size(); /**/ ) {
+        if (slot[k].key <= t) {
+          arriving.push_back(slot[k]);
+          slot[k] = slot.back();
+          slot.pop_back();
+        } else {
+          ++k;
+        }
+      }
+    }
+  }
+  horizon = t;
+
+  // move entries from the overflow which are now within the wheel's span
+  if (overflow_min < t + SPAN) {
+    overflow_min = std::numeric_limits < Timestamp > :: infinity();
+    for (size_t k = 0; k < overflow.size(); /**/ ) {
+      Entry & e = overflow[k];
+      if (e.key < t + SPAN) {
+        if (e.key <= t)
+          arriving.push_back(e);
+        else
+          add_future(e);
+        e = overflow.back();
+        overflow.pop_back();
+      } else {
+        if (e.key < overflow_min)
+          overflow_min = e.key;
+        ++k;
+      }
+    }
+  }
+
+  // arriving keys are all greater than the old horizon, and so
+  // greater than every key already in the ready region
+  std::sort(arriving.begin(), arriving.end(), before);
+  ready.insert(ready.end(), arriving.begin(), arriving.end());
+  Profile pr;
+  for (auto & e : arriving) {
+    get_profile(e.tc, pr);
+    ready_pr.push_back(pr);
+  }
+};
+
+void
+Cand_List::remove_ready(size_t i) {
+  ready[i].tc = 0;
+  --num_live;
+  ++num_removed;
+};
+
+void
+Cand_List::remove(Timestamp key, unsigned long long seq) {
+  if (key <= horizon) {
+    Entry e = {key, seq, 0};
+    auto i = std::lower_bound(ready.begin(), ready.end(), e, before);
+    if (i != ready.end() && i->seq == seq && i->tc)
+      remove_ready(i - ready.begin());
+    return;
+  }
+  // the entry is in its slot, unless it was put in the overflow
+  // and hasn't been moved since
+  auto take = [&] (std::vector < Entry > & v) {
+    for (size_t k = 0; k < v.size(); ++k) {
+      if (v[k].seq == seq) {
+        v[k] = v.back();
+        v.pop_back();
+        --num_live;
+        return true;
+      }
+    }
+    return false;
+  };
+  if (! (slots.size() && take(slots[slot_num(key) & (NUM_SLOTS - 1)])))
+    take(overflow);
+};
+
+void
+Cand_List::compact() {
+  // the ready region is scanned for every pulse, so don't let
+  // removed entries make up more than a quarter of it
+  if (num_removed * 4 <= ready.size())
+    return;
+  size_t j = 0;
+  for (size_t i = 0; i < ready.size(); ++i) {
+    if (ready[i].tc) {
+      if (j != i) {
+        ready[j] = ready[i];
+        ready_pr.move(i, j);
+      }
+      ++j;
+    }
+  }
+  ready.resize(j);
+  ready_pr.resize(j);
+  num_removed = 0;
+};
+
+void
+Cand_List::remove_if(std::function < bool (Tag_Candidate *) > pred, std::vector < Tag_Candidate * > & removed) {
+  for (size_t i = 0; i < ready.size(); ++i) {
+    if (ready[i].tc && pred(ready[i].tc)) {
+      removed.push_back(ready[i].tc);
+      remove_ready(i);
+    }
+  }
+
+  // entries in the wheel and overflow are unordered, so collect
+  // those to be removed and sort them
+  static std::vector < Entry > found;
+  found.clear();
+  auto take = [&] (std::vector < Entry > & v) {
+    for (size_t k = 0; k < v.size(); /**/ ) {
+      if (pred(v[k].tc)) {
+        found.push_back(v[k]);
+        v[k] = v.back();
+        v.pop_back();
+      } else {
+        ++k;
+      }
+    }
+  };
+  for (auto & slot : slots)
+    take(slot);
+  take(overflow);
+  std::sort(found.begin(), found.end(), before);
+  for (auto & e : found)
+    removed.push_back(e.tc);
+  num_live -= found.size();
+};
+
+void
+Cand_List::get_all(std::vector < Entry > & all) const {
+  for (auto & e : ready)
+    if (e.tc)
+      all.push_back(e);
+  size_t n = all.size();
+  for (auto & slot : slots)
+    all.insert(all.end(), slot.begin(), slot.end());
+  all.insert(all.end(), overflow.begin(), overflow.end());
+  std::sort(all.begin() + n, all.end(), before);
+};
+
+void
+Cand_List::reprofile() {
+  Profile pr;
+  for (size_t i = 0; i < ready.size(); ++i) {
+    if (ready[i].tc) {
+      get_profile(ready[i].tc, pr);
+      ready_pr.set(i, pr);
+    }
+  }
+};
+
+size_t
+Cand_List::filter(Timestamp ts, float dfreq, float sig, std::vector < unsigned char > & visit) const {
+  // NaN compares false, so would fail every range, even unbounded ones
+  if (std::isnan(dfreq) || std::isnan(sig))
+    return 0;
+
+  size_t n = ready.size();
+  visit.resize(n);
+
+  // the same tests as Tag_Candidate::expired and Bounded_Range::is_compatible,
+  // in the same precision; written without branches or early exits,
+  // so the loop vectorizes
+
+  const Timestamp * last_ts = ready_pr.last_ts.data();
+  const Gap * max_age = ready_pr.max_age.data();
+  const double * f_low = ready_pr.f_low.data();
+  const double * f_high = ready_pr.f_high.data();
+  const double * f_width = ready_pr.f_width.data();
+  const float * s_low = ready_pr.s_low.data();
+  const float * s_high = ready_pr.s_high.data();
+  const float * s_width = ready_pr.s_width.data();
+  unsigned char * v = visit.data();
+  double f = dfreq;
+
+  for (size_t i = 0; i < n; ++i) {
+    bool expired = ts - last_ts[i] > max_age[i];
+    bool f_ok = (f_high[i] - f <= f_width[i]) & (f - f_low[i] <= f_width[i]);
+    bool s_ok = (s_high[i] - sig <= s_width[i]) & (sig - s_low[i] <= s_width[i]);
+    v[i] = expired | (f_ok & s_ok);
+  }
+  return n;
+};
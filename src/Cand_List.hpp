@@ -0,0 +1,170 @@
+#ifndef CAND_LIST_HPP
+#define CAND_LIST_HPP
+
+#include "find_tags_common.hpp"
+
+#include <functional>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/level.hpp>
+
+class Tag_Candidate;
+
+/*
+  Cand_List - the tag candidates at one Tag_ID_Level in a Tag_Finder,
+  ordered by the earliest time at which each can accept a pulse (its
+  "key"), and among candidates with the same key, by order of insertion.
+
+  This is a calendar queue: candidates whose key is at most the
+  "horizon" (the latest time the list has been advanced to) are
+  in the ready region, a vector sorted by key and kept in list order.
+  Later candidates sit unsorted in a wheel of NUM_SLOTS slots, each
+  SLOT_WIDTH seconds wide, or in an overflow vector if their key is
+  beyond the span of the wheel.  Advancing the list to a new time
+  moves the slots it passes into the ready region, sorting only those.
+
+  Inserting a candidate is O(1), except that a key at or before the
+  horizon goes into its sorted place in the ready region.  Removing a
+  candidate from the ready region just clears its entry, so that
+  positions of other entries don't change while the ready region is
+  being scanned; cleared entries are dropped by compact().
+
+  As a candidate enters the ready region, the list takes a Profile of
+  it from a Profiler: the fields which decide whether it could possibly
+  accept a pulse.  Profiles are kept field by field in arrays parallel
+  to the ready region, so that filter() can test all ready candidates
+  against a pulse in one pass which the compiler vectorizes, without
+  touching the candidates themselves.
+
+  The list is serialized as the std::multimap it replaced, with the
+  same key and order.
+*/
+
+class Cand_List {
+
+public:
+
+  struct Entry {
+    Timestamp key;            //!< earliest time at which the candidate can accept a pulse
+    unsigned long long seq;   //!< order of insertion, for ties in key
+    Tag_Candidate * tc;       //!< the candidate; 0 for a removed entry in the ready region
+  };
+
+  //!< A candidate can't accept a pulse at ts with frequency offset
+  // dfreq and signal sig if it hasn't expired (ts - last_ts <= max_age)
+  // and either f_high - dfreq > f_width, dfreq - f_low > f_width,
+  // or the same for sig.  Unbounded ranges have infinite width, and
+  // candidates whose expiry can't be known in advance have
+  // max_age = -Inf, so they are never filtered out.
+  struct Profile {
+    Timestamp last_ts;
+    Gap max_age;
+    double f_low, f_high, f_width;
+    float s_low, s_high, s_width;
+  };
+
+  typedef void (*Profiler) (Tag_Candidate * tc, Profile & pr); //!< get the profile of a candidate
+
+  static const Profile UNFILTERED; //!< profile of a candidate which filter() always passes
+
+  static constexpr Gap SLOT_WIDTH = 0.125; //!< seconds spanned by each slot of the wheel
+  static const int NUM_SLOTS = 1024;       //!< slots in the wheel; must be a power of two
+
+  Cand_List();
+
+  void set_profiler(Profiler p); //!< profile candidates with p; until this is called, all have profile UNFILTERED
+
+  unsigned long long insert(Timestamp key, Tag_Candidate * tc); //!< add tc with the given key, after any other candidates with that key; returns its seq
+
+  size_t size() const { return num_live; }; //!< number of candidates
+
+  void advance(Timestamp t); //!< make ready all candidates with key <= t
+
+  size_t num_ready() const { return ready.size(); }; //!< number of entries in the ready region, including removed ones
+
+  Entry & ready_at(size_t i) { return ready[i]; }; //!< i'th entry in the ready region; its tc may be replaced directly
+
+  void remove_ready(size_t i); //!< remove the candidate in the i'th entry of the ready region
+
+  void remove(Timestamp key, unsigned long long seq); //!< remove the candidate inserted with key and seq
+
+  void compact(); //!< drop removed entries from the ready region, if there are enough of them to slow scans
+
+  //!< remove all candidates for which pred is true, appending them to
+  // removed in list order; may be called while the ready region is
+  // being scanned
+  void remove_if(std::function < bool (Tag_Candidate *) > pred, std::vector < Tag_Candidate * > & removed);
+
+  void get_all(std::vector < Entry > & all) const; //!< get entries for all candidates, in list order
+
+  void reprofile(); //!< take new profiles of all ready candidates, after something they depend on has changed
+
+  //!< set visit[i] to 0 if the candidate in the i'th entry of the ready
+  // region can't accept a pulse at ts with frequency offset dfreq and
+  // signal sig, and to 1 if it might; returns the number of entries
+  // tested, which is all of them, unless dfreq or sig is NaN, in which
+  // case nothing is filtered and 0 is returned
+  size_t filter(Timestamp ts, float dfreq, float sig, std::vector < unsigned char > & visit) const;
+
+  template < class Archive >
+  void save(Archive & ar, const unsigned int version) const {
+    std::vector < Entry > all;
+    get_all(all);
+    std::multimap < Timestamp, Tag_Candidate * > m;
+    for (auto & e : all)
+      m.insert(m.end(), std::make_pair(e.key, e.tc));
+    ar << m;
+  };
+
+  template < class Archive >
+  void load(Archive & ar, const unsigned int version) {
+    std::multimap < Timestamp, Tag_Candidate * > m;
+    ar >> m;
+    for (auto & e : m)
+      insert(e.first, e.second);
+  };
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER();
+
+protected:
+
+  // profiles of the entries in the ready region, one array per field
+  struct Profile_Columns {
+    std::vector < Timestamp > last_ts;
+    std::vector < Gap > max_age;
+    std::vector < double > f_low, f_high, f_width;
+    std::vector < float > s_low, s_high, s_width;
+
+    void push_back(const Profile & pr);
+    void insert(size_t i, const Profile & pr);
+    void set(size_t i, const Profile & pr);
+    void move(size_t from, size_t to); //!< copy the profile at from to to
+    void resize(size_t n);
+  };
+
+  Profiler profiler;                           //!< gets profiles of candidates entering the ready region; 0 if none
+  std::vector < Entry > ready;                 //!< entries with key <= horizon, sorted by key then seq
+  Profile_Columns ready_pr;                    //!< profiles of the candidates in ready
+  std::vector < std::vector < Entry > > slots; //!< wheel of entries with horizon < key < horizon + span; allocated on first use
+  std::vector < Entry > overflow;              //!< entries with key >= horizon + span, when they were inserted or last checked
+  Timestamp horizon;                           //!< time to which the list has been advanced
+  Timestamp overflow_min;                      //!< no key in overflow is smaller than this
+  unsigned long long next_seq;                 //!< seq for the next inserted entry
+  size_t num_live;                             //!< number of candidates
+  size_t num_removed;                          //!< number of removed entries in the ready region
+
+  static constexpr Gap SPAN = SLOT_WIDTH * NUM_SLOTS; //!< seconds spanned by the wheel
+
+  static long long slot_num(Timestamp key) { return (long long) floor(key / SLOT_WIDTH); }; //!< unwrapped slot number for key
+
+  void add_future(const Entry & e); //!< add an entry with key > horizon to the wheel or overflow
+
+  void get_profile(Tag_Candidate * tc, Profile & pr) const { if (profiler) profiler(tc, pr); else pr = UNFILTERED; };
+
+  static bool before(const Entry & a, const Entry & b) { return a.key < b.key || (a.key == b.key && a.seq < b.seq); };
+};
+
+BOOST_CLASS_IMPLEMENTATION(Cand_List, boost::serialization::object_serializable);
+
+#endif // CAND_LIST_HPP
@@ -11,11 +11,11 @@ Clock_Repair::Clock_Repair(Data_Source *data, unsigned long long *line_no, DB_Fi
   tol(tol),
   cp(),
   gpsv(),
+  buffered(),
   GPSstuck(false),
   correcting(false),
   offset(0.0),
-  offsetError(0.0),
-  buf()
+  offsetError(0.0)
 {
   init();
 };
@@ -79,28 +79,30 @@ Clock_Repair::got_estimate() {
 // if no records are available, return false.
 bool
 Clock_Repair::read_record(SG_Record & r) {
-  while (data->getline(buf, MAX_LINE_SIZE)) {
+  while (data->get_record(r)) {
     ++ *line_no;
-    r.from_buf(buf);
     if (r.type == SG_Record::BAD) {
       if (++num_bad_line_warnings <= MAX_BAD_LINE_WARNINGS ) {
-        std::cerr << "Warning: malformed line in input\n  at line " << * line_no << ":\n" << (string("") + buf) << std::endl;
+        std::cerr << "Warning: malformed line in input\n  at line " << * line_no << ":\n" << data->last_line() << std::endl;
         if (num_bad_line_warnings == MAX_BAD_LINE_WARNINGS)
           std::cerr << "(skipping further warnings about this)" << std::endl;
       }
       continue;
     }
-    if (r.ts > max_ts
-        || (isMonotonic(r.ts) && r.ts + TS_BEAGLEBONE_BOOT > max_ts)
-        || (isPreGPS(r.ts) && offset > 0.0 && r.ts + offset > max_ts)) {
-      // timestamp too large!
+    if (too_late(r))
       continue;
-    }
     return true;
   }
   return false;
 };
 
+bool
+Clock_Repair::too_late(SG_Record & r) {
+  return r.ts > max_ts
+    || (isMonotonic(r.ts) && r.ts + TS_BEAGLEBONE_BOOT > max_ts)
+    || (isPreGPS(r.ts) && offset > 0.0 && r.ts + offset > max_ts);
+};
+
 bool
 Clock_Repair::get(SG_Record &r) {
 //!< get the next record available for processing, correct its
@@ -116,14 +118,24 @@ Clock_Repair::get(SG_Record &r) {
         got_estimate();
         break;
       }
+      buffered.put(r); // as read, since handle() alters the timestamp
       handle(r);
     }
     filer->add_time_fix(TS_BEAGLEBONE_BOOT, TS_SG_EPOCH, offset, offsetError, 'S');
-    data->rewind();
+    buffered.start_replay();
     GPSstuck = false;  // on next round, unstick GPS so we get initial run of non-stuck records
   }
-  if (! read_record(r))
-    return false;
+  // return buffered records first; these were read with no offset
+  // known, so re-check their timestamps now that we have one
+  for (;;) {
+    if (! buffered.get(r)) {
+      if (! read_record(r))
+        return false;
+      break;
+    }
+    if (! too_late(r))
+      break;
+  }
   if (isMonotonic(r.ts))
     // always correct monotonic timestamps to pre-GPS
     r.ts += TS_BEAGLEBONE_BOOT;
@@ -134,6 +146,14 @@ Clock_Repair::get(SG_Record &r) {
   return true;
 };
 
+void
+Clock_Repair::get_time_fix(Timestamp & tsLow, Timestamp & tsHigh, Timestamp & by, Timestamp & error) {
+  tsLow = TS_BEAGLEBONE_BOOT;
+  tsHigh = TS_SG_EPOCH;
+  by = offset;
+  error = offsetError;
+};
+
 Timestamp
 Clock_Repair::max_ts = 0;
 
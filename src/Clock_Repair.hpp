@@ -7,15 +7,17 @@
 #include "Clock_Pinner.hpp"
 #include "GPS_Validator.hpp"
 #include "Data_Source.hpp"
+#include "SG_Record_Buffer.hpp"
 
 class Clock_Repair {
 
 // ## Clock_Repair - a filter that repairs timestamps in SG records
 //
 //   This class accepts a sequence of records from raw SG data files, and tries
-//   to correct faulty timestamps.  When a reasonably good correction is possible,
-//   the data source is rewound and timestamps are corrected before the
-//   records are returned to the instance's user.
+//   to correct faulty timestamps.  Records are buffered until a reasonably good
+//   correction is possible; then the buffered records, followed by the rest of
+//   the data source, have their timestamps corrected before being returned to
+//   the instance's user.
 //
 //   This class would not be necessary if the SG on-board software and the GPS
 //   were working correctly.
@@ -116,9 +118,13 @@ class Clock_Repair {
 //        - splits up clock fixing logic between Clock_Repair and Tag_Foray
 //        - need to implement restarts on data sources
 //
-// To avoid arbitrarily large buffer sizes, we went with a slightly hybrid
-// version of the two choices above.  We use rewinds() but keep all
-// clock fixing logic in this class.
+// We originally went with a slightly hybrid version of the two choices
+// above, using rewinds() but keeping all clock fixing logic in this class.
+// That meant reading and parsing all input twice for receivers which
+// never get a GPS fix, and losing records read before the estimate from
+// sources which can't be rewound.  Now we use the Filter approach: records
+// are kept in a compact SG_Record_Buffer, which writes them to a temporary
+// file beyond a size cap, so the buffer size is no longer a concern.
 
 public:
 
@@ -132,6 +138,10 @@ public:
   // if no (corrected) records are available, return false.
   bool get(SG_Record &r);
 
+  //!< the time fix filed once a correction estimate was made, as passed
+  // to DB_Filer::add_time_fix()
+  void get_time_fix(Timestamp & tsLow, Timestamp & tsHigh, Timestamp & by, Timestamp & error);
+
 protected:
 
   //!< indicate there are no more input records
@@ -143,6 +153,9 @@ protected:
   //!< try read a record from the data source
   bool read_record( SG_Record & r);
 
+  //!< is the record's timestamp too large, given the current offset?
+  bool too_late( SG_Record & r);
+
   typedef enum {  // sources of timestamps (i.e. what kind of record in the raw file)
     TSS_PULSE = 0,  // pulse record
     TSS_GPS   = 1,  // GPS record
@@ -170,6 +183,7 @@ protected:
   Timestamp tol;  //!< maximum allowed error (seconds) in correcting timestamps
   Clock_Pinner cp;    //!< for pinning CLOCK_PRE_GPS to CLOCK_REALTIME
   GPS_Validator gpsv; //!< for detecting a stuck GPS
+  SG_Record_Buffer buffered; //!< records read before we were able to correct; replayed once we are
 
   bool GPSstuck; // true iff we see the GPS is stuck, as determined by the GPS_Validator class
   bool correcting; //!< true if we're able to correct records
@@ -177,8 +191,6 @@ protected:
   Timestamp offset;
   Timestamp offsetError;
 
-  char buf[MAX_LINE_SIZE + 1]; //!< input buffer
-
   //!< are pulses using CLOCK_MONOTONIC?
   bool clock_monotonic();
 
@@ -6,6 +6,10 @@
 #include <dirent.h>
 
 DB_Filer::DB_Filer (const string &out, const string &prog_name, const string &prog_version, double prog_ts, int  bootnum, double minGPSdt):
+  out_path(out),
+  st_get_blob(0),
+  blob_prefetch(0),
+  prefetcher(0),
   prog_name(prog_name),
   num_hits(0),
   num_steps(0),
@@ -151,36 +155,8 @@ DB_Filer::DB_Filer (const string &out, const string &prog_name, const string &pr
 
   const char * ftsm = "SQLite output database does not have valid 'batchState' table";
 
-  sqlite3_enable_load_extension(outdb, 1);
-
-  const static int MAX_PATH_SIZE = 2048;
-  char extension_lib_path_buffer[2*MAX_PATH_SIZE + 1];
-  int n = readlink("/proc/self/exe", extension_lib_path_buffer, MAX_PATH_SIZE);
-  for (;;) { // not a loop
-    if (n > 0) {
-      extension_lib_path_buffer[n] = '\0';
-      char * dir_slash = (char *) memrchr(extension_lib_path_buffer, '/', n);
-      if (dir_slash) {
-        strcpy( dir_slash + 1, "Sqlite_Compression_Extension.so");
-        Check( sqlite3_prepare_v2(outdb,
-                                  q_load_extension,
-                                  -1,
-                                  &st_load_extension,
-                                  0),
-               "Can't prepare statement to load extension library!");
-
-        sqlite3_bind_text(st_load_extension, 1, extension_lib_path_buffer, -1, SQLITE_STATIC);
-        int res = sqlite3_step(st_load_extension);
-        if (res == SQLITE_DONE || res == SQLITE_ROW) {
-          sqlite3_finalize(st_load_extension);
-          st_load_extension = 0;
-          break;
-        }
-      }
-    }
-    // all errors end up here
+  if (! load_extension(outdb))
     throw std::runtime_error("Unable to load Sqlite_Compression_Extension.so from folder with `find_tags_motus`");
-  };
 
   Check ( sqlite3_prepare_v2(outdb, q_save_findtags_state, -1, & st_save_findtags_state, 0), ftsm);
   sqlite3_bind_text(st_save_findtags_state, 2, prog_name.c_str(), -1, SQLITE_TRANSIENT);
@@ -615,6 +591,24 @@ where
 order by ts)
 )";
 
+// the same files as q_get_blob, without reading them; for Blob_Prefetcher
+
+const char *
+DB_Filer::q_get_blob_manifest = R"(select ts,
+printf('%s/%s/%s%s',
+       ?,
+       strftime('%Y-%m-%d', datetime(t1.ts, 'unixepoch')),
+       t1.name,
+       case isDone when 0 then '' else '.gz' end) as filename,
+t1.isDone as compressed,
+t1.fileID as fileID
+from
+   files as t1
+where
+   t1.monoBN=?
+order by ts
+)";
+
 const char *
 DB_Filer::q_add_batch_file = "insert or ignore into batchFiles values (?, ?)";
 //                                                                     1  2
@@ -622,12 +616,42 @@ DB_Filer::q_add_batch_file = "insert or ignore into batchFiles values (?, ?)";
 const char *
 DB_Filer::q_load_extension = "select load_extension(?)";
 
+bool
+DB_Filer::load_extension(sqlite3 * db) {
+  sqlite3_enable_load_extension(db, 1);
+
+  const static int MAX_PATH_SIZE = 2048;
+  char extension_lib_path_buffer[2*MAX_PATH_SIZE + 1];
+  int n = readlink("/proc/self/exe", extension_lib_path_buffer, MAX_PATH_SIZE);
+  if (n <= 0)
+    return false;
+  extension_lib_path_buffer[n] = '\0';
+  char * dir_slash = (char *) memrchr(extension_lib_path_buffer, '/', n);
+  if (! dir_slash)
+    return false;
+  strcpy( dir_slash + 1, "Sqlite_Compression_Extension.so");
+
+  sqlite3_stmt * st_load_extension;
+  if (sqlite3_prepare_v2(db, q_load_extension, -1, &st_load_extension, 0) != SQLITE_OK)
+    throw std::runtime_error("Can't prepare statement to load extension library!");
+
+  sqlite3_bind_text(st_load_extension, 1, extension_lib_path_buffer, -1, SQLITE_STATIC);
+  int res = sqlite3_step(st_load_extension);
+  sqlite3_finalize(st_load_extension);
+  return res == SQLITE_DONE || res == SQLITE_ROW;
+};
+
+void
+DB_Filer::set_blob_prefetch(int numFiles) {
+  blob_prefetch = numFiles;
+};
+
 void
 DB_Filer::start_blob_reader(int monoBN) {
 
 
   Check( sqlite3_prepare_v2(outdb,
-                            q_get_blob,
+                            blob_prefetch > 0 ? q_get_blob_manifest : q_get_blob,
                             -1,
                             &st_get_blob,
                             0),
@@ -665,6 +689,27 @@ DB_Filer::start_blob_reader(int monoBN) {
 
   sqlite3_bind_int(st_get_blob, 2, monoBN);
 
+  // initially, assume we're starting at the first file in that boot session, by specifying fileTS=0.
+  // this might be changed by the resume() code.
+  if (blob_prefetch > 0) {
+    // read the whole list of files now, and hand it to the prefetcher
+    std::vector < Blob_Prefetcher::File > files;
+    int res;
+    while ((res = sqlite3_step(st_get_blob)) == SQLITE_ROW) {
+      Blob_Prefetcher::File f;
+      f.ts = sqlite3_column_double(st_get_blob, 0);
+      f.path = std::string((const char *) sqlite3_column_text(st_get_blob, 1));
+      f.compressed = sqlite3_column_int(st_get_blob, 2);
+      f.fileID = sqlite3_column_int(st_get_blob, 3);
+      files.push_back(f);
+    }
+    Check(res, SQLITE_DONE, "Problem getting list of files.");
+    sqlite3_finalize(st_get_blob);
+    st_get_blob = 0;
+    prefetcher = new Blob_Prefetcher(out_path, files, blob_prefetch);
+    return;
+  }
+
   // initially, assume we're starting at the first file in that boot session, by specifying fileTS=0.
   // this might be changed by the resume() code.
   sqlite3_bind_int(st_get_blob, 3, 0);
@@ -672,11 +717,25 @@ DB_Filer::start_blob_reader(int monoBN) {
 
 void
 DB_Filer::seek_blob (Timestamp tsseek) {
-  sqlite3_bind_int(st_get_blob, 3, tsseek);
+  // NB: files are selected by comparing their timestamps to tsseek truncated to an integer
+  if (prefetcher)
+    prefetcher->seek((int) tsseek);
+  else
+    sqlite3_bind_int(st_get_blob, 3, tsseek);
 };
 
 bool
 DB_Filer::get_blob (const char **bufout, int * lenout, Timestamp *ts) {
+  if (prefetcher) {
+    int fileID;
+    if (! prefetcher->get(bufout, lenout, ts, & fileID))
+      return false;
+    sqlite3_bind_int(st_add_batch_file, 1, bid);
+    sqlite3_bind_int(st_add_batch_file, 2, fileID);
+    step_commit(st_add_batch_file);
+    return true;
+  }
+
   int res = sqlite3_step(st_get_blob);
   if (res == SQLITE_DONE)
     return false; // indicate we're done
@@ -702,13 +761,51 @@ DB_Filer::get_blob (const char **bufout, int * lenout, Timestamp *ts) {
 
 void
 DB_Filer::rewind_blob_reader(Timestamp origin) {
-  sqlite3_reset (st_get_blob);
+  if (! prefetcher)
+    sqlite3_reset (st_get_blob);
   seek_blob(origin);
 };
 
 void
 DB_Filer::end_blob_reader () {
   sqlite3_finalize (st_get_blob);
+  st_get_blob = 0;
+  delete prefetcher;
+  prefetcher = 0;
+};
+
+const char *
+DB_Filer::q_get_file_set = "select fileID, size, isDone from files where monoBN=? order by fileID";
+
+std::vector < long long >
+DB_Filer::get_file_set(int monoBN) {
+  sqlite3_stmt * st;
+  Check(sqlite3_prepare_v2(outdb, q_get_file_set, -1, &st, 0),
+        "SQLite input database does not have valid 'files' table.");
+  sqlite3_bind_int(st, 1, monoBN);
+  std::vector < long long > fs;
+  int res;
+  while ((res = sqlite3_step(st)) == SQLITE_ROW)
+    for (int i = 0; i < 3; ++i)
+      fs.push_back(sqlite3_column_int64(st, i));
+  sqlite3_finalize(st);
+  Check(res, SQLITE_DONE, "Problem getting list of files.");
+  return fs;
+};
+
+const char *
+DB_Filer::q_add_batch_files = "insert or ignore into batchFiles select ?, fileID from files where monoBN=?";
+//                                                                     1                                 2
+
+void
+DB_Filer::add_batch_files(int monoBN) {
+  sqlite3_stmt * st;
+  Check(sqlite3_prepare_v2(outdb, q_add_batch_files, -1, &st, 0),
+        "SQLite input database does not have valid 'batchFiles' table.");
+  sqlite3_bind_int(st, 1, bid);
+  sqlite3_bind_int(st, 2, monoBN);
+  step_commit(st);
+  sqlite3_finalize(st);
 };
 
 const char *
@@ -7,6 +7,7 @@
 #include "Ambiguity.hpp"
 #include "Tag_Database.hpp"
 #include "Pulse.hpp"
+#include "Blob_Prefetcher.hpp"
 
 /*
   DB_Filer - manage sqlite databases (input for data file indexes, resuming state; output for detections and saving state)
@@ -65,6 +66,8 @@ public:
 
   bool load_findtags_state(long long monoBN, Timestamp & tsData, Timestamp & tsRun, std::string & state, int version, int &blob_version);
 
+  void set_blob_prefetch(int numFiles); //!< set number of files to read and decompress ahead, on worker threads; 0 means read each file when needed; must be called before start_blob_reader()
+
   void start_blob_reader(int monoBN); //!< initialize reading of filecontents blobs for a given boot number
 
   void seek_blob (Timestamp tsseek); //!< skip to the first blob whose file timestamp >= ts.  This is used for resuming.
@@ -75,6 +78,10 @@ public:
 
   void end_blob_reader(); //!< finalize blob reader
 
+  std::vector < long long > get_file_set(int monoBN); //!< fileID, size and isDone of each file in a boot session, by fileID; identifies the input to a run over the whole session
+
+  void add_batch_files(int monoBN); //!< record that the current batch used every file in a boot session
+
   void start_DTAtags_reader(Timestamp ts = 0, int bootnum = 0); //!< initialize reading of DTAtags lines, starting at the specified timestamp and boot number
 
   bool get_DTAtags_record(DTA_Record &dta ); //!< get the next DTAtags record; return true on success, false if none left; set items in &dat.
@@ -87,10 +94,13 @@ public:
 
   void add_recv_param(Timestamp ts, int ant, char *param, double val, int error, char *extra); //!< record a receiver parameter setting
 
+  static bool load_extension(sqlite3 * db); //!< load Sqlite_Compression_Extension.so from the folder with this program into a connection; return true on success
+
 protected:
   // settings
 
   sqlite3 * outdb; //<! handle to sqlite connection
+  string out_path; //!< path to output database
 
   // sqlite3 pre-compiled statements
   sqlite3_stmt * st_begin_batch; //!< create a batch record
@@ -116,7 +126,9 @@ protected:
   sqlite3_stmt * st_add_pulse; //!< record a pulse
   sqlite3_stmt * st_add_recv_param; //!< record a receiver parameter setting
   sqlite3_stmt * st_add_batch_file; //!< record use of an input file
-  sqlite3_stmt * st_load_extension; //!< load an extension library
+
+  int blob_prefetch; //!< number of files to read ahead in blob reader
+  Blob_Prefetcher * prefetcher; //!< reads files ahead on worker threads; 0 if not prefetching
 
   string prog_name; //!< name of program, for recording in DB
 
@@ -172,10 +184,13 @@ protected:
   static const char * q_save_findtags_state;
   static const char * q_get_file_repo;
   static const char * q_get_blob;
+  static const char * q_get_blob_manifest;
   static const char * q_get_DTAtags;
   static const char * q_add_pulse;
   static const char * q_add_recv_param;
   static const char * q_add_batch_file;
+  static const char * q_get_file_set;
+  static const char * q_add_batch_files;
   static const char * q_load_extension;
 
 };
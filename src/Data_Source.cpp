@@ -1,19 +1,61 @@
 #include "Data_Source.hpp"
 #include "Lotek_Data_Source.hpp"
+#include "Record_Cache_Data_Source.hpp"
 #include "SG_File_Data_Source.hpp"
+#include "SG_File_Tree_Data_Source.hpp"
 #include "SG_SQLite_Data_Source.hpp"
 
 #include <iostream>
+#include <string.h>
 
-Data_Source::Data_Source() {};
+Data_Source::Data_Source() :
+  last_line_start(0),
+  last_line_len(0)
+{};
 
 Data_Source::~Data_Source(){};
 
+bool
+Data_Source::getline(char * buf, int maxLen) {
+  throw std::runtime_error("This data source does not provide lines of text");
+};
+
+bool
+Data_Source::getline_view(const char * & line, int & len) {
+  if (! getline(line_buf, MAX_LINE_SIZE))
+    return false;
+  line = line_buf;
+  len = strlen(line_buf);
+  return true;
+};
+
+bool
+Data_Source::get_record(SG_Record & r) {
+  const char * line;
+  int len;
+  if (! getline_view(line, len))
+    return false;
+  // truncate to max permitted line size; we silently discard the remainder
+  if (len > (int) MAX_LINE_SIZE)
+    len = MAX_LINE_SIZE;
+  r.from_buf(line, len);
+  last_line_start = line;
+  last_line_len = len;
+  return true;
+};
+
+std::string
+Data_Source::last_line() {
+  if (! last_line_start)
+    return std::string();
+  return std::string(last_line_start, last_line_len);
+};
+
 Data_Source *
 Data_Source::make_SG_source(std::string infile) {
   if (infile.length() == 0)
     return new SG_File_Data_Source(& std::cin);
-  return new SG_File_Data_Source(new std::ifstream(infile));
+  return new SG_File_Tree_Data_Source(infile);
 };
 
 Data_Source *
@@ -21,6 +63,17 @@ Data_Source::make_SQLite_source(DB_Filer * db, unsigned int monoBN) {
   return new SG_SQLite_Data_Source(db, monoBN);
 };
 
+Data_Source *
+Data_Source::make_Record_Cache_source(DB_Filer * db, unsigned int monoBN, std::string path) {
+  Record_Cache_Data_Source * s = new Record_Cache_Data_Source(path, monoBN, db->get_file_set(monoBN));
+  if (! s->valid()) {
+    delete s;
+    return 0;
+  }
+  s->file_batch_info(db, monoBN);
+  return s;
+};
+
 Data_Source *
 Data_Source::make_Lotek_source(DB_Filer * db, Tag_Database *tdb, Frequency_MHz defFreq, int bootnum) {
   return new Lotek_Data_Source(db, tdb, defFreq, bootnum);
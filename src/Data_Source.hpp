@@ -1,13 +1,14 @@
 #ifndef DATA_SOURCE_HPP
 #define DATA_SOURCE_HPP
 
-//!< Source for input data.  Data is either in sensorgnome format, from a file, stream,
-//!< or motus .sqlite file,
+//!< Source for input data.  Data is either in sensorgnome format, from a stream,
+//!< raw files, or motus .sqlite file,
 //!< or in Lotek format (generated by wrapper code in the motus R package)
 
 #include "find_tags_common.hpp"
 #include "Tag_Database.hpp"
 #include "DB_Filer.hpp"
+#include "SG_Record.hpp"
 
 using boost::serialization::make_nvp;
 
@@ -16,9 +17,34 @@ class Data_Source {
 
 public:
   Data_Source();
-  ~Data_Source();
+  virtual ~Data_Source();
 
-  virtual bool getline(char * buf, int maxLen) = 0;
+  virtual bool getline(char * buf, int maxLen); //!< copy the next line of text into buf; sources without text throw
+
+  //!< get the next line of input as a view: on return, `line` points
+  // to its first character and `len` is its length, not including any
+  // newline.  The text is not 0-terminated, and stays valid only
+  // until the next call to a method of this source.  Returns false
+  // if no lines remain.
+  // The default implementation copies the line into this object's
+  // own buffer using getline(); sources which hold their input in
+  // memory should override it to avoid the copy.
+  virtual bool getline_view(const char * & line, int & len);
+
+  //!< get the next input record; returns false if none remain.
+  // The default implementation parses the next line from getline_view(),
+  // truncated to MAX_LINE_SIZE characters; sources whose input is
+  // already structured (e.g. Lotek detections) override this to build
+  // records directly, without going through text.
+  virtual bool get_record(SG_Record & r);
+
+  //!< text of the line from which the most recent record was parsed,
+  // for diagnostics; empty if the source doesn't provide text.
+  virtual std::string last_line();
+
+  //!< do records from this source already have corrected timestamps?
+  // If so, they are used as-is, rather than passing through Clock_Repair.
+  virtual bool has_corrected_timestamps() { return false; };
 
   virtual void serialize(boost::archive::binary_iarchive & ar, const unsigned int version){};
 
@@ -28,10 +54,16 @@ public:
 
   static Data_Source * make_SQLite_source(DB_Filer * dbf, unsigned int monoBN=0);
 
-  static Data_Source * make_SG_source(std::string infile);
+  static Data_Source * make_SG_source(std::string infile); //!< stdin if infile is empty; otherwise see SG_File_Tree_Data_Source
+
+  static Data_Source * make_Record_Cache_source(DB_Filer * db, unsigned int monoBN, std::string path); //!< 0 unless path is a valid record cache for the current files in boot session monoBN; see Record_Cache
 
   static Data_Source * make_Lotek_source(DB_Filer * db, Tag_Database *tdb, Frequency_MHz defFreq, int bootnum);
 
+protected:
+  char line_buf[MAX_LINE_SIZE + 1]; //!< buffer for default implementation of getline_view()
+  const char * last_line_start; //!< start of line from which the most recent record was parsed
+  int last_line_len; //!< length of line from which the most recent record was parsed
 };
 
 #endif // DATA_SOURCE
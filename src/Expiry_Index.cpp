@@ -0,0 +1,79 @@
+#include "Expiry_Index.hpp"
+
+#include "Tag_Candidate.hpp"
+
+Timestamp
+Expiry_Index::expiry(Tag_Candidate * tc) {
+  return tc->last_ts + tc->get_max_age();
+};
+
+void
+Expiry_Index::place(size_t i, const Entry & e) {
+  heap[i] = e;
+  e.tc->expiry_slot = i;
+};
+
+void
+Expiry_Index::sift_up(size_t i) {
+  Entry e = heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (! (e.ts < heap[parent].ts))
+      break;
+    place(i, heap[parent]);
+    i = parent;
+  }
+  place(i, e);
+};
+
+void
+Expiry_Index::sift_down(size_t i) {
+  Entry e = heap[i];
+  size_t n = heap.size();
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= n)
+      break;
+    if (child + 1 < n && heap[child + 1].ts < heap[child].ts)
+      ++child;
+    if (! (heap[child].ts < e.ts))
+      break;
+    place(i, heap[child]);
+    i = child;
+  }
+  place(i, e);
+};
+
+void
+Expiry_Index::add(Tag_Candidate * tc) {
+  heap.push_back(Entry {expiry(tc), tc});
+  sift_up(heap.size() - 1);
+};
+
+void
+Expiry_Index::update(Tag_Candidate * tc) {
+  size_t i = tc->expiry_slot;
+  Timestamp old_ts = heap[i].ts;
+  heap[i].ts = expiry(tc);
+  if (heap[i].ts < old_ts)
+    sift_up(i);
+  else
+    sift_down(i);
+};
+
+void
+Expiry_Index::remove(Tag_Candidate * tc) {
+  size_t i = tc->expiry_slot;
+  if (i == NOT_INDEXED)
+    return;
+  tc->expiry_slot = NOT_INDEXED;
+  Entry last = heap.back();
+  heap.pop_back();
+  if (i == heap.size())
+    return;
+  place(i, last);
+  if (i > 0 && last.ts < heap[(i - 1) / 2].ts)
+    sift_up(i);
+  else
+    sift_down(i);
+};
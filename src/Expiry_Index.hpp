@@ -0,0 +1,52 @@
+#ifndef EXPIRY_INDEX_HPP
+#define EXPIRY_INDEX_HPP
+
+#include "find_tags_common.hpp"
+
+class Tag_Candidate;
+
+/*
+  Expiry_Index - the tag candidates of a Tag_Finder, ordered by the time
+  after which they expire (last_ts + state->get_max_age()), so that
+  expired candidates can be found without scanning the others.
+
+  This is a binary heap.  Each candidate records its position in the
+  heap, so it can be moved when its expiry time changes, and removed
+  when it is deleted.
+*/
+
+class Expiry_Index {
+
+public:
+
+  static const size_t NOT_INDEXED = (size_t) -1; //!< heap position of a candidate not in any index
+
+  void add(Tag_Candidate * tc); //!< index tc by its current expiry time
+
+  void update(Tag_Candidate * tc); //!< re-index tc after its last_ts or state has changed
+
+  void remove(Tag_Candidate * tc); //!< remove tc; does nothing if tc is not indexed
+
+  bool empty() const { return heap.empty(); };
+
+  Timestamp first_ts() const { return heap[0].ts; }; //!< earliest expiry time; index must not be empty
+
+  Tag_Candidate * first() const { return heap[0].tc; }; //!< candidate expiring first; index must not be empty
+
+protected:
+
+  struct Entry {
+    Timestamp ts;       //!< time after which tc expires
+    Tag_Candidate * tc;
+  };
+
+  std::vector < Entry > heap;
+
+  static Timestamp expiry(Tag_Candidate * tc); //!< time after which tc will have expired
+
+  void place(size_t i, const Entry & e); //!< put e at position i, recording that in its candidate
+  void sift_up(size_t i);
+  void sift_down(size_t i);
+};
+
+#endif // EXPIRY_INDEX_HPP
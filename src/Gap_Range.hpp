@@ -10,6 +10,8 @@ struct Gap_Range {
   Gap chunkDown(Gap g, Gap chunkiness) { return chunkiness * floor(g / chunkiness);};
   Gap chunkUp  (Gap g, Gap chunkiness) { return chunkiness * ceil (g / chunkiness);};
 
+  Gap_Range() : first(0), second(0) {};
+
   Gap_Range(Gap first, Gap second) : first(first), second(second) {};
 
   Gap_Range(Gap g, Gap tol, float timeFuzz) :
@@ -17,6 +19,12 @@ struct Gap_Range {
     second(chunkUp  (std::max(g + tol, g * (1 + timeFuzz)), tol))
   {
   };
+
+  template < class Archive >
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & BOOST_SERIALIZATION_NVP( first );
+    ar & BOOST_SERIALIZATION_NVP( second );
+  };
 };
 
 typedef std::vector < Gap_Range > Gap_Ranges;
@@ -9,7 +9,11 @@ Graph::Graph(std::string vizPrefix) :
   vizPrefix(vizPrefix),
   numViz(0),
   setToNode(100),
-  stamp(1)
+  stamp(1),
+  table(),
+  bulk(false),
+  bulkPending(),
+  rootRange()
 {
   _root = new Node();
   //  _root->link();
@@ -36,8 +40,80 @@ Graph::root() {
   return _root;
 };
 
+void
+Graph::beginBulk(const std::vector < Tag * > & tags) {
+  // Adding tags one at a time would copy the root's ever-larger set
+  // for each, and rebuild the flattened edges of the root, which
+  // every tag adds edges to, for each.  So put all tags in the root's
+  // set at once, in the phase _addTag would, and leave compiling
+  // nodes until endBulk.  Tags which turn out to be ambiguous, and
+  // so aren't added, are taken out again.  Proxies are left out, as
+  // Ambiguity might rename a tag to one.
+
+  bulk = true;
+  TagPhaseSet s = _root->s->s;
+  for (auto t : tags)
+    if (t->motusID > 0 && ! _root->s->count(t) && bulkPending.insert(t).second)
+      s.push_back(TagPhase(t, 0));
+  _root->setSet(Set::make(s));
+};
+
+void
+Graph::endBulk() {
+  if (bulkPending.size()) {
+    TagPhaseSet s;
+    for (auto & tp : _root->s->s)
+      if (! bulkPending.count(tp.first))
+        s.push_back(tp);
+    _root->setSet(Set::make(s));
+    bulkPending.clear();
+  }
+  bulk = false;
+  for (auto i = setToNode.begin(); i != setToNode.end(); ++i)
+    if (i->second->stale)
+      i->second->compile();
+  table.clear();
+};
+
+void
+Graph::recompile(Node * n) {
+  if (bulk)
+    n->stale = true;
+  else
+    n->compile();
+};
+
+Node *
+Graph::advance(Node * n, Gap dt) {
+  if (! n->stale)
+    return n->advance(dt);
+  auto i = n->e.upper_bound(dt);
+  --i;
+  if (i->second != Node::empty())
+    return i->second;
+  for (auto & p : n->pe)
+    if (p.match(dt))
+      return p.target != Node::empty() ? p.target : 0;
+  return 0;
+};
+
+void
+Graph::edgesFor(Node * n, Tag * t, Node::Edges::iterator & begin, Node::Edges::iterator & end) {
+  begin = n->e.begin();
+  end = n->e.end();
+  if (n != _root)
+    return;
+  auto i = rootRange.find(t);
+  if (i == rootRange.end())
+    return;
+  begin = n->e.upper_bound(i->second.first);
+  --begin; // the edge covering the start of the range
+  end = n->e.lower_bound(i->second.second);
+};
+
 std::pair < Tag *, Tag * >
 Graph::addTag(Tag * tag, double tol, double timeFuzz, double maxTime, unsigned int timestamp_wonkiness) {
+  table.clear();
 #ifdef ACTIVE_TAG_DIAGNOSTICS
   active_tags.insert(tag);
 #endif // ACTIVE_TAG_DIAGNOSTICS
@@ -50,8 +126,12 @@ Graph::addTag(Tag * tag, double tol, double timeFuzz, double maxTime, unsigned i
   if (! ot) {
     // tag not already present, so just add
     _addTag(tag, tol, timeFuzz, maxTime, timestamp_wonkiness);
+    rootRange.insert(std::make_pair(tag, Gap_Range(tag->gaps[0], tol, timeFuzz)));
     return std::make_pair((Tag *) 0, (Tag *) 0);
   }
+  // the tag won't be added, so it mustn't be left in the root's set
+  if (bulkPending.erase(tag))
+    erase_at_root(tag);
   // another tag is ambiguous with this one (i.e. pulses from this one
   // would be detected as an other, existing tag)
   // Manage the ambiguity by replacing the existing tag with a proxy
@@ -63,6 +143,7 @@ Graph::addTag(Tag * tag, double tol, double timeFuzz, double maxTime, unsigned i
 
 std::pair < Tag *, Tag * >
 Graph::delTag(Tag * tag) {
+  table.clear();
 #ifdef ACTIVE_TAG_DIAGNOSTICS
   active_tags.erase(tag);
 #endif // ACTIVE_TAG_DIAGNOSTICS
@@ -70,6 +151,7 @@ Graph::delTag(Tag * tag) {
   if (!p) {
     // tag has not been proxied, so just delete
     _delTag(tag);
+    rootRange.erase(tag);
     return std::make_pair((Tag *) 0, (Tag *) 0);
   }
   // this tag is part of an ambiguity set which has been proxied in the tree
@@ -152,11 +234,8 @@ Graph::_addTag(Tag *tag, double tol, double timeFuzz, double maxTime, unsigned i
   // to missed bursts immediately after the first (only if n > 1; a beeper tag has n = 1)
 
   // back edges
-  Gap_Ranges grs;
-  for(g = tag->gaps[n - 1]; g < maxTime; g += tag->period)
-    grs.push_back(Gap_Range(g, tol, timeFuzz));
-
-  insertRec(grs, TagPhase(tag, 2 * n - 1), TagPhase(tag, n)); // self-linked edges for a beeper tag: 2 * 1 - 1 == 1
+  Periodic_Edge back(tag->gaps[n - 1], tag->period, 0, tol, timeFuzz, maxTime);
+  insertRec(back, TagPhase(tag, 2 * n - 1), TagPhase(tag, n)); // self-linked edges for a beeper tag: 2 * 1 - 1 == 1
 
   // skip edges (only for n > 1).  FIXME:  We are privileging the last gap because
   // for coded ID tags, it is typically much larger than the others, so that the pulses
@@ -164,12 +243,9 @@ Graph::_addTag(Tag *tag, double tol, double timeFuzz, double maxTime, unsigned i
   // approach, especially at low-noise, low-activity sites, would be to add edges for any number
   // of missed pulses, not just entire "bursts".
 
-  if (n > 1) {
-    grs.clear();
-    for(g = tag->gaps[n - 1] + tag->period; g < maxTime; g += tag->period)
-      grs.push_back(Gap_Range(g, tol, timeFuzz));
-    insertRec(grs, TagPhase(tag, n - 1), TagPhase(tag, n));
-  }
+  Periodic_Edge skip(tag->gaps[n - 1] + tag->period, tag->period, 0, tol, timeFuzz, maxTime);
+  if (n > 1)
+    insertRec(skip, TagPhase(tag, n - 1), TagPhase(tag, n));
 
   if (timestamp_wonkiness > 0) {
     // timestamp wonkiness: to handle clock jumps of +/- 1s in data from Lotek .DTA files, we add extra nodes
@@ -179,41 +255,43 @@ Graph::_addTag(Tag *tag, double tol, double timeFuzz, double maxTime, unsigned i
     // G-, where the clock has jumped back by 1s; phases 2*n, 2*n+1, ..., 3*n-1
     // G+, where the clock has jumped forward by 1s; phases 3*n, 3*n+1, ..., 4*n-1
 
-    Gap_Ranges grsPlus, grsMinus;
-    for(g = tag->gaps[n - 1] + tag->period; g < maxTime; g += tag->period) {
-      grsPlus.push_back(Gap_Range(g + 1, tol, timeFuzz));
-      grsMinus.push_back(Gap_Range(g - 1, tol, timeFuzz));
-    }
+    Periodic_Edge plus (tag->gaps[n - 1] + tag->period, tag->period,  1, tol, timeFuzz, maxTime);
+    Periodic_Edge minus(tag->gaps[n - 1] + tag->period, tag->period, -1, tol, timeFuzz, maxTime);
+
+    // the "within" edges are the skip edges, except for a beeper tag,
+    // which has none, so gets the back edges
+
+    const Periodic_Edge & within = n > 1 ? skip : back;
 
     // 1. edges/nodes for G-, the "clock jumped back by 1s" subgraph
 
     // a) long edges (clock jump possible)
-    //  insertRec(grsMinus, TagPhase(tag, n - 1),     TagPhase(tag, 2 * n)); // to (after 1st burst)
-    insertRec(grsMinus, TagPhase(tag, 2 * n - 1), TagPhase(tag, 2 * n)); // to (after later bursts)
-    insertRec(grsPlus,  TagPhase(tag, 3 * n - 1), TagPhase(tag, n - 1)); // from
-    insertRec(grs,      TagPhase(tag, 3 * n - 1), TagPhase(tag, 2 * n)); // within
+    //  insertRec(minus, TagPhase(tag, n - 1),     TagPhase(tag, 2 * n)); // to (after 1st burst)
+    insertRec(minus,  TagPhase(tag, 2 * n - 1), TagPhase(tag, 2 * n)); // to (after later bursts)
+    insertRec(plus,   TagPhase(tag, 3 * n - 1), TagPhase(tag, n - 1)); // from
+    insertRec(within, TagPhase(tag, 3 * n - 1), TagPhase(tag, 2 * n)); // within
 
     // b) short edges (no clock jump possible)
 
-    for(i = 0; i < n - 1; ++i ) {
+    for(i = 0; i < n - 1 && i < within.count; ++i ) {
       Gap_Ranges grs2;
-      grs2.push_back(grs[i]);
+      grs2.push_back(within.range(i));
       insertRec(grs2, TagPhase(tag, 2 * n + i), TagPhase(tag, 2 * n + i + 1));
     }
 
     // 2. edges/nodes for G+, the "clock jumped forward by 1s" subgraph
 
     // a) long edges (clock jump possible)
-    //  insertRec(grsPlus,  TagPhase(tag, n - 1),     TagPhase(tag, 3 * n)); // to (after 1st burst)
-    insertRec(grsPlus,  TagPhase(tag, 2 * n - 1), TagPhase(tag, 3 * n)); // to (after later bursts)
-    insertRec(grsMinus, TagPhase(tag, 4 * n - 1), TagPhase(tag, n - 1)); // from
-    insertRec(grs,      TagPhase(tag, 4 * n - 1), TagPhase(tag, 3 * n)); // within
+    //  insertRec(plus,   TagPhase(tag, n - 1),     TagPhase(tag, 3 * n)); // to (after 1st burst)
+    insertRec(plus,   TagPhase(tag, 2 * n - 1), TagPhase(tag, 3 * n)); // to (after later bursts)
+    insertRec(minus,  TagPhase(tag, 4 * n - 1), TagPhase(tag, n - 1)); // from
+    insertRec(within, TagPhase(tag, 4 * n - 1), TagPhase(tag, 3 * n)); // within
 
     // b) short edges (no clock jump possible)
 
-    for(i = 0; i < n - 1; ++i ) {
+    for(i = 0; i < n - 1 && i < within.count; ++i ) {
       Gap_Ranges grs2;
-      grs2.push_back(grs[i]);
+      grs2.push_back(within.range(i));
       insertRec(grs2, TagPhase(tag, 3 * n + i), TagPhase(tag, 3 * n + i+1));
     }
   }
@@ -248,7 +326,7 @@ Graph::find(Tag * tag, double tol, double timeFuzz) {
   Gap g;
   for (i = 0; i < ng - 1; ++i) {
     g = tag->gaps[i];
-    n = n->advance(g);
+    n = advance(n, g);
     if (! n)
       return 0;
   }
@@ -264,7 +342,7 @@ Graph::find(Tag * tag, double tol, double timeFuzz) {
   gg.push_back(gr.second);
 
   for (i = 0; i < gg.size(); ++i) {
-    auto m = n->advance(gg[i]);
+    auto m = advance(n, gg[i]);
     if (m) {
       if (m->s->s.size() > 1)
         throw std::runtime_error("Graph::find: tag not unique");
@@ -311,6 +389,16 @@ Graph::viz() {
         }
       }
     }
+    for (auto & p : i->second->pe) {
+      if (p.target->s != Set::empty()) {
+        auto n = setToNode.find(p.target->s);
+        if (n != setToNode.end()) {
+          Gap_Range r = p.range(0);
+          out << "a" << i->second->label << " -> a" << (n->second->label) << "[label = \"["
+              << r.first << "," << r.second << "] + k * " << p.period << ", k < " << p.count << "\"];\n";
+        }
+      }
+    }
   }
   out << "}\n";
 };
@@ -383,14 +471,16 @@ Graph::unmapSet ( Set * s) {
 
 void
 Graph::insert (const TagPhase &t) {
-    _root->s = _root->s->augment(t);
+    if (bulkPending.erase(t.first))
+      return; // put there by beginBulk
+    _root->setSet(_root->s->augment(t));
     // note: we don't remap root in setToNode, since we
     // never try to lookup the root node from its set.
 };
 
 void
 Graph::erase_at_root (Tag * t) {
-  _root->s = _root->s->reduce(t);
+  _root->setSet(_root->s->reduce(t));
     // note: we don't remap root in setToNode
 };
 
@@ -459,81 +549,86 @@ Graph::unlinkNode (Node *n) {
       unlinkNode(i->second);
       i = j;
     }
+    for (auto & p : n->pe)
+      for (int k = p.num_live(); k > 0; --k)
+        unlinkNode(p.target);
     n->drop();
   };
 };
 
 void
-Graph::augmentEdge(Node::Edges::iterator i, TagPhase p) {
+Graph::augmentEdge(Node * & tail, TagPhase p, int links) {
   // given an existing edge, augment its tail node by p
 
-  Node * n = i->second;
-  Set * s = n->s->cloneAugment(p);
+  Node * n = tail;
+  Set * s = n->s->augment(p);
   auto j = setToNode.find(s);
   if (j != setToNode.end()) {
     // already have a node for this set
-    unlinkNode(n);
-    delete s;
-    i->second = j->second;
-    linkNode(i->second);
+    for (int k = 0; k < links; ++k)
+      unlinkNode(n);
+    tail = j->second;
+    for (int k = 0; k < links; ++k)
+      linkNode(tail);
     return;
   }
   if (n->useCount == 1) {
     // special case to save work: re-use this node
     unmapSet(n->s);
-    n->s = n->s->augment(p);
-    mapSet(n->s, n);
-    delete s;
+    n->setSet(s);
+    mapSet(s, n);
     return;
   }
   // create new node with augmented set, but preserving
   // its outgoing edges
   Node * nn = new Node(n);
-  nn->s = s;
+  nn->setSet(s);
   mapSet(s, nn);
   // adjust incoming edge counts on old and new nodes
-  unlinkNode(n);
-  linkNode(nn);
-  i->second = nn;
+  for (int k = 0; k < links; ++k)
+    unlinkNode(n);
+  for (int k = 0; k < links; ++k)
+    linkNode(nn);
+  tail = nn;
 };
 
 
 void
-Graph::reduceEdge(Node::Edges::iterator i, Tag * t) {
+Graph::reduceEdge(Node * & tail, Tag * t, int links) {
   // given an existing edge, reduce its tail node by t
 
-  Node * n = i->second;
+  Node * n = tail;
   if (n->s->count(t) == 0)
     return;
-  Set * s = n->s->cloneReduce(t);
+  Set * s = n->s->reduce(t);
   auto j = setToNode.find(s);
   if (j != setToNode.end()) {
     // already have a node for this set
-    if (s != Set::empty())
-      delete s;
-    i->second = j->second;
-    linkNode(i->second);
-    unlinkNode(n);
+    tail = j->second;
+    for (int k = 0; k < links; ++k)
+      linkNode(tail);
+    for (int k = 0; k < links; ++k)
+      unlinkNode(n);
     return;
   }
   if (n->useCount == 1) {
     // special case to save work: re-use this node
     unmapSet(n->s);
-    n->s = n->s->reduce(t);
-    mapSet(n->s, n);
-    if (s != Set::empty())
-      delete s;
+    n->setSet(s);
+    mapSet(s, n);
     return;
   }
   // create new node with reduced set, but preserving
   // its outgoing edges
   Node * nn = new Node(n);
-  nn->s = s;
+  nn->setSet(s);
   mapSet(s, nn);
   // adjust incoming edge counts on old and new nodes
-  unlinkNode(n);
-  linkNode(nn);
-  i->second = nn;
+  for (int k = 0; k < links; ++k)
+    unlinkNode(n);
+  for (int k = 0; k < links; ++k)
+    linkNode(nn);
+  tail = nn;
 };
 
 
@@ -548,12 +643,68 @@ Graph::dropEdgeIfExtra(Node * n, Node::Edges::iterator i)
 
   auto j = i;
   --j;
-  if (* (i->second->s) == * (j->second->s)) {
+  if (i->second->s == j->second->s) {
     unlinkNode(i->second);
     n->e.erase(i);
+    recompile(n);
   };
 };
 
+bool
+Graph::overlapsEdge(Node * n, Gap lo, Gap hi) {
+  auto i = n->e.upper_bound(lo);
+  --i;  // i->first is now <= lo
+  for (/**/; i->first < hi; ++i)
+    if (i->second != Node::empty())
+      return true;
+  return false;
+};
+
+void
+Graph::materialize(Node * n, Gap lo, Gap hi) {
+  std::vector < int > ks;
+  for (size_t i = 0; i < n->pe.size(); ++i) {
+    ks.clear();
+    n->pe[i].overlapping(lo, hi, ks);
+    for (auto k : ks)
+      materialize(n, i, k);
+  }
+};
+
+void
+Graph::materialize(Node * n, size_t i, int k) {
+  // add occurrence k as ordinary edges, which is what it would have
+  // been if it had been inserted as a Gap_Range; the range leads to
+  // the empty node, so inserting each tag phase of the target's set
+  // leads it to the target.  Its link to the target is dropped only
+  // afterwards, so that the target survives.
+
+  Periodic_Edge & pe = n->pe[i];
+  if (! pe.is_live(k))
+    return;
+  pe.materialize(k);
+  Gap_Range r = pe.range(k);
+  Node * t = pe.target;
+  if (t == Node::empty()) {
+    // the target was reduced away, but the edges would remain
+    ensureEdge(n, r.second);
+    ensureEdge(n, r.first);
+    recompile(n);
+  } else {
+    TagPhaseSet tps = t->s->s;
+    for (auto & tp : tps) {
+      Gap_Ranges grs(1, r);
+      insert(n, grs, TagPhase(tp.first, tp.second));
+    }
+  }
+  // a periodic edge with no live occurrences holds no links, so mustn't
+  // keep its target; it is dropped by the next insert of a periodic
+  // edge, as n's periodic edges might be being iterated over now
+  if (pe.num_live() == 0)
+    pe.target = Node::empty();
+  unlinkNode(t);
+};
+
 void
 Graph::insert (Node *n, Gap_Ranges & grs, TagPhase p)
 {
@@ -563,6 +714,9 @@ Graph::insert (Node *n, Gap_Ranges & grs, TagPhase p)
     // From the node at n, add appropriate edges to other nodes
     // given that the segment [lo, hi] is being augmented by p.
 
+    if (n->pe.size())
+      materialize(n, lo, hi);
+
     ensureEdge(n, hi);  // ensure there is an edge from n at hi to the
     // current node for that point
 
@@ -576,10 +730,70 @@ Graph::insert (Node *n, Gap_Ranges & grs, TagPhase p)
     while (i->first < hi) {
       auto j = i;
       ++j;
-      augmentEdge(i, p);
+      augmentEdge(i->second, p);
       i = j;
     }
   }
+  recompile(n);
+};
+
+void
+Graph::insert (Node *n, const Periodic_Edge & pe, TagPhase p)
+{
+  // From the node at n, add a periodic edge augmented by p.  Its
+  // occurrences must not overlap edges to non-empty nodes, or live
+  // occurrences of n's other periodic edges, so any which do are
+  // inserted as ordinary edges, along with any of its other
+  // occurrences which overlap those.
+
+  n->pe.erase(std::remove_if(n->pe.begin(), n->pe.end(), [](const Periodic_Edge & p) { return p.num_live() == 0; }), n->pe.end());
+
+  Periodic_Edge q(pe);
+  std::vector < char > conflict(q.count);
+  std::vector < int > ks;
+  for (int k = 0; k < q.count; ++k) {
+    Gap_Range r = q.range(k);
+    conflict[k] = overlapsEdge(n, r.first, r.second);
+    for (size_t i = 0; i < n->pe.size() && ! conflict[k]; ++i) {
+      ks.clear();
+      n->pe[i].overlapping(r.first, r.second, ks);
+      conflict[k] = ! ks.empty();
+    }
+  }
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (int k = 0; k < q.count; ++k) {
+      if (! conflict[k])
+        continue;
+      Gap_Range r = q.range(k);
+      for (int j = k + 1; j < q.count && q.range(j).first < r.second; ++j)
+        if (! conflict[j])
+          conflict[j] = changed = true;
+      for (int j = k - 1; j >= 0 && r.first < q.range(j).second; --j)
+        if (! conflict[j])
+          conflict[j] = changed = true;
+    }
+  }
+
+  Gap_Ranges grs;
+  for (int k = 0; k < q.count; ++k) {
+    if (conflict[k]) {
+      grs.push_back(q.range(k));
+      q.materialize(k);
+    }
+  }
+  if (grs.size())
+    insert(n, grs, p);
+
+  int links = q.num_live();
+  if (links == 0)
+    return;
+  q.target = Node::empty();
+  for (int k = 0; k < links; ++k)
+    linkNode(q.target);
+  augmentEdge(q.target, p, links);
+  n->pe.push_back(q);
+  recompile(n);
 };
 
 void
@@ -589,7 +803,14 @@ Graph::insertRec (Gap_Ranges & grs, TagPhase tFrom, TagPhase tTo) {
 };
 
 void
-Graph::insertRec (Node *n, Gap_Ranges & grs, TagPhase tFrom, TagPhase tTo) {
+Graph::insertRec (const Periodic_Edge & pe, TagPhase tFrom, TagPhase tTo) {
+  newStamp();
+  insertRec (_root, pe, tFrom, tTo);
+};
+
+template < class EDGES >
+void
+Graph::insertRec (Node *n, EDGES & edges, TagPhase tFrom, TagPhase tTo) {
   // recursively insert a transition from tFrom to tTo
 
   // Because this is a DAG, rather than a tree, a given node might
@@ -599,23 +820,57 @@ Graph::insertRec (Node *n, Gap_Ranges & grs, TagPhase tFrom, TagPhase tTo) {
 
   auto id = tFrom.first;
   n->stamp = stamp;
-  for(auto i = n->e.begin(); i != n->e.end(); ) {
+  Node::Edges::iterator begin, end;
+  edgesFor(n, id, begin, end);
+  for(auto i = begin; i != end; ) {
     auto j = i;
     ++j;
     if (i->second->stamp != stamp && i->second->s->count(id)) {
-      insertRec(i->second, grs, tFrom, tTo);
+      insertRec(i->second, edges, tFrom, tTo);
     }
     i = j;
   }
+  for (size_t i = 0; i < n->pe.size(); ++i) {
+    Node * m = n->pe[i].target;
+    if (m->stamp != stamp && m->s->count(id))
+      insertRec(m, edges, tFrom, tTo);
+  }
   // possibly add edge from this node
   if (n->s->count(tFrom))
-    insert(n, grs, tTo);
+    insert(n, edges, tTo);
 };
 
 void
 Graph::renTag(Tag *t1, Tag *t2) {
+  table.clear();
+  // rename while t1's range still limits the scan of the root's
+  // edges, noting first whether t2 was already in the graph
+  bool had_t2 = _root->s->count(t2);
   newStamp();
   renTagRec(_root, t1, t2);
+  if (t1 == t2)
+    return;
+
+  // t2's edges from the root are where t1's were, and where its own
+  // were if it was already in the graph; unknown if either is
+  auto i = rootRange.find(t1);
+  bool known = i != rootRange.end();
+  Gap_Range r = known ? i->second : Gap_Range(0, 0);
+  if (known)
+    rootRange.erase(i);
+  auto j = rootRange.find(t2);
+  if (had_t2) {
+    if (j != rootRange.end()) {
+      if (known) {
+        j->second.first = std::min(j->second.first, r.first);
+        j->second.second = std::max(j->second.second, r.second);
+      } else {
+        rootRange.erase(j);
+      }
+    }
+  } else if (known) {
+    rootRange.insert(std::make_pair(t2, r));
+  }
 };
 
 void
@@ -625,24 +880,28 @@ Graph::renTagRec(Node * n, Tag *t1, Tag *t2) {
   n->stamp = stamp;
 
   // check descendents first
-  for(auto i = n->e.begin(); i != n->e.end(); ++i)
+  Node::Edges::iterator begin, end;
+  edgesFor(n, t1, begin, end);
+  for(auto i = begin; i != end; ++i)
     if (i->second->stamp != stamp && i->second->s->count(t1))
       renTagRec(i->second, t1, t2);
+  for (auto & p : n->pe)
+    if (p.target->stamp != stamp && p.target->s->count(t1))
+      renTagRec(p.target, t1, t2);
 
   // for this node's set, replace any tagphase having t1
-  // with a tagphase having t2
+  // with a tagphase having t2; the root isn't mapped by its set
 
-  TagPhaseSet & s = n->s->s;
-  auto r = s.equal_range(t1);
-
-  for (auto i = r.first; i != r.second; /**/) {
-    auto j = i;
-    ++j;
-    auto p = i->second;
-    s.erase(i);
-    s.insert(std::make_pair(t2, p));
-    i = j;
+  Set * s = n->s->rename(t1, t2);
+  if (s == n->s)
+    return;
+  if (n == _root) {
+    n->setSet(s);
+    return;
   }
+  unmapSet(n->s);
+  n->setSet(s);
+  mapSet(s, n);
 };
 
 void
@@ -651,14 +910,21 @@ Graph::erase (Node *n, Tag * t) {
   // If edges at lo and/or hi become redundant after
   // this, remove them.
 
-  for(auto i = n->e.begin(); i != n->e.end(); ) {
+  Node::Edges::iterator begin, end;
+  edgesFor(n, t, begin, end);
+  for(auto i = begin; i != end; ) {
     auto j = i;
     ++j;
     if (i->second->s->count(t)) {
-      reduceEdge(i, t);
+      reduceEdge(i->second, t);
     }
     i = j;
   }
+  // a periodic edge whose target is reduced to the empty set is kept,
+  // as its ordinary edges would have been
+  for (auto & p : n->pe)
+    reduceEdge(p.target, t, p.num_live());
+  recompile(n);
 
   // Algorithm that only looks at edges in range
   // for (auto gr = grs.begin(); gr != grs.end(); ++gr) {
@@ -691,7 +957,9 @@ Graph::eraseRec (Node *n, Tag *t) {
   // recursively erase tag t
   n->stamp = stamp;
   bool here = n->s->count(t) > 0;
-  for(auto i = n->e.begin(); i != n->e.end(); ) {
+  Node::Edges::iterator begin, end;
+  edgesFor(n, t, begin, end);
+  for(auto i = begin; i != end; ) {
     auto j = i;
     ++j;
     if (i->second->stamp != stamp && i->second->s->count(t)) {
@@ -701,6 +969,11 @@ Graph::eraseRec (Node *n, Tag *t) {
     }
     i = j;
   }
+  for (size_t i = 0; i < n->pe.size(); ++i) {
+    Node * m = n->pe[i].target;
+    if (m->stamp != stamp && m->s->count(t))
+      eraseRec(m, t);
+  }
   if (here)
     erase(n, t);
 };
@@ -726,6 +999,9 @@ Graph::findTagRec(Node * n, Tag * tag)
         findTagRec(i->second, tag);
       }
     }
+    for (auto & p : n->pe)
+      if (p.target->stamp != stamp)
+        findTagRec(p.target, tag);
     // see whether tag is in this node's set (at any phase)
     if (n->s->count(tag)) {
       ++findCount;
@@ -5,6 +5,8 @@
 #include "Node.hpp"
 #include "Ambiguity.hpp"
 #include "Gap_Range.hpp"
+#include "Periodic_Edge.hpp"
+#include "Graph_Table.hpp"
 
 class Graph {
   // the graph representing a DFA for the NDFA full-burst recognition
@@ -27,6 +29,22 @@ protected:
   // nodes get stamped with 0 and the new stamp value is set to 1.
   int stamp;
 
+  // compiled copy of the graph, for walking between tag events; cleared
+  // whenever the graph changes.  Not serialized.
+  Graph_Table table;
+
+  // while adding a batch of tags (see beginBulk), nodes are marked
+  // stale instead of being compiled after each change; endBulk
+  // compiles them.  Not serialized.
+  bool bulk;
+  TagSet bulkPending; //!< tags beginBulk put in the root's set which haven't been added yet
+
+  // for each tag added by addTag, the range of gaps within which
+  // edges from the root lead to nodes with that tag, so searches for
+  // it needn't scan all of the root's edges; a tag without an entry
+  // might have such edges anywhere.
+  std::unordered_map < Tag *, Gap_Range > rootRange;
+
 #ifdef ACTIVE_TAG_DIAGNOSTICS
   // set of active tags, for diagnostics
   TagSet active_tags;
@@ -40,6 +58,9 @@ public:
   std::pair < Tag *, Tag * >  delTag(Tag * tag); //!< remove a tag from the tree, handling ambiguity
   void renTag(Tag *t1, Tag *t2);//!< "rename" tag t1 to tag t2
   Tag * find(Tag * tag, double tol, double timeFuzz);
+  Graph_Table & get_table() { return table; }; //!< compiled copy of the graph as it is now
+  void beginBulk(const std::vector < Tag * > & tags); //!< prepare for addTag to be called for (some of) tags, in order, and nothing else but addTag or delTag until endBulk
+  void endBulk(); //!< finish adding tags after beginBulk
   void viz();
   void dumpSetToNode();
   void validateSetToNode();
@@ -53,6 +74,12 @@ protected:
 
   void resetAllStamps();
 
+  void recompile(Node * n); //!< compile n after its edges have changed, or mark it stale during a bulk add
+
+  Node * advance(Node * n, Gap dt); //!< n->advance(dt), but also correct for a stale node
+
+  void edgesFor(Node * n, Tag * t, Node::Edges::iterator & begin, Node::Edges::iterator & end); //!< range of edges from n which might lead to nodes with t
+
   void mapSet( Set * s, Node * n);
 
   void unmapSet ( Set * s);
@@ -73,17 +100,28 @@ protected:
 
   void unlinkNode (Node *n);
 
-  void augmentEdge(Node::Edges::iterator i, TagPhase p);
+  void augmentEdge(Node * & tail, TagPhase p, int links = 1); //!< augment the tail node of an edge (or of a periodic edge holding links links) by p
 
-  void reduceEdge(Node::Edges::iterator i, Tag * t);
+  void reduceEdge(Node * & tail, Tag * t, int links = 1); //!< reduce the tail node of an edge (or of a periodic edge holding links links) by t
 
   void dropEdgeIfExtra(Node * n, Node::Edges::iterator i);
 
+  bool overlapsEdge(Node * n, Gap lo, Gap hi); //!< does any edge from n lead to a non-empty node for gaps in [lo, hi)?
+
+  void materialize(Node * n, Gap lo, Gap hi); //!< replace live occurrences of periodic edges from n overlapping [lo, hi) with ordinary edges
+
+  void materialize(Node * n, size_t i, int k); //!< replace occurrence k of n's i'th periodic edge with ordinary edges
+
   void insert (Node *n, Gap_Ranges & gr, TagPhase p);
 
+  void insert (Node *n, const Periodic_Edge & pe, TagPhase p);
+
   void insertRec (Gap_Ranges & gr, TagPhase tFrom, TagPhase tTo);
 
-  void insertRec (Node * n, Gap_Ranges & gr, TagPhase tFrom, TagPhase tTo);
+  void insertRec (const Periodic_Edge & pe, TagPhase tFrom, TagPhase tTo);
+
+  template < class EDGES >
+  void insertRec (Node * n, EDGES & edges, TagPhase tFrom, TagPhase tTo);
 
   void erase (Node * n, Tag * t);
 
@@ -112,6 +150,7 @@ public:
     ar & BOOST_SERIALIZATION_NVP( numViz );
     ar & BOOST_SERIALIZATION_NVP( setToNode );
     ar & BOOST_SERIALIZATION_NVP( stamp );
+    ar & BOOST_SERIALIZATION_NVP( rootRange );
   };
 };
 
@@ -0,0 +1,90 @@
+#include "Graph_Table.hpp"
+
+#include "Node.hpp"
+
+Graph_Table::Graph_Table() :
+  gen(++last_gen),
+  states(),
+  cuts(),
+  next(),
+  periodic(),
+  buckets()
+{
+};
+
+void
+Graph_Table::clear() {
+  gen = ++last_gen;
+  states.clear();
+  cuts.clear();
+  next.clear();
+  periodic.clear();
+  buckets.clear();
+};
+
+Graph_Table::State_ID
+Graph_Table::id_of(Node * n) {
+  if (n->table_gen == gen)
+    return n->table_id;
+  if (n == Node::empty() || ! n->valid())
+    return NO_STATE;
+  n->table_gen = gen;
+  n->table_id = states.size();
+  State st;
+  st.node = n;
+  st.compiled = false;
+  states.push_back(st);
+  return n->table_id;
+};
+
+void
+Graph_Table::compile(State_ID s) {
+  // the successors of a node in the graph are in the graph too, so
+  // only the empty node gets NO_STATE here
+
+  Node * n = states[s].node;
+  unsigned first = cuts.size();
+  cuts.insert(cuts.end(), n->cuts.begin(), n->cuts.end());
+  for (auto m : n->next)
+    next.push_back(id_of(m));
+  unsigned first_periodic = periodic.size();
+  for (size_t i = 0; i < n->num_scanned; ++i) {
+    Periodic p = {& n->pe[i], id_of(n->pe[i].target)};
+    periodic.push_back(p);
+  }
+  unsigned first_bucket = buckets.size();
+  buckets.insert(buckets.end(), n->buckets.begin(), n->buckets.end());
+
+  // id_of may have reallocated states
+  State & st = states[s];
+  st.first_edge = first;
+  st.num_edges = n->cuts.size();
+  st.first_periodic = first_periodic;
+  st.num_periodic = n->num_scanned;
+  st.first_bucket = first_bucket;
+  st.num_buckets = n->buckets.size();
+  st.bucket_lo = n->bucket_lo;
+  st.bucket_scale = n->bucket_scale;
+  st.min_age = n->get_min_age();
+  st.max_age = n->get_max_age();
+  st.unique = n->is_unique();
+  st.tag = st.unique ? n->get_tag() : BOGUS_TAG;
+  st.phase = st.unique ? n->get_phase() : BOGUS_PHASE;
+  st.compiled = true;
+};
+
+Graph_Table::State_ID
+Graph_Table::advance(State_ID s, Gap dt) {
+  // same search as Node::advance, over this state's run of edges
+
+  const State & st = state(s);
+  State_ID r = next[st.first_edge + Node::find_cut(& cuts[st.first_edge], st.num_edges, buckets.data() + st.first_bucket, st.num_buckets, st.bucket_lo, st.bucket_scale, dt)];
+  if (r != NO_STATE)
+    return r;
+  for (unsigned i = st.first_periodic; i < st.first_periodic + st.num_periodic; ++i)
+    if (periodic[i].edge->match(dt))
+      return periodic[i].next;
+  return NO_STATE;
+};
+
+unsigned Graph_Table::last_gen = 0;
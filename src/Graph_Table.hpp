@@ -0,0 +1,94 @@
+#ifndef GRAPH_TABLE_HPP
+#define GRAPH_TABLE_HPP
+
+#include "find_tags_common.hpp"
+#include "Periodic_Edge.hpp"
+
+class Node;
+
+/*
+  Graph_Table - a compiled copy of a Graph's DFA, for Tag_Candidates
+  to walk between tag events.
+
+  Each Node of the graph which candidates reach becomes a state with
+  an integer ID.  The state records what candidates need to know about
+  its node (tag, phase, uniqueness, min and max age).  The edges of all
+  states are stored in two contiguous arrays, with each state's edges
+  in a single run, and leading to state IDs rather than Nodes.  So
+  walking the table doesn't touch Nodes or Sets, whose storage is
+  scattered over the heap.  A state whose node has buckets for finding
+  edges has a copy of them in a further array.  Periodic edges which the node tests one
+  by one are listed in a third array, referring to the node's copy.
+
+  States are compiled when first reached, rather than all at once: a
+  tag event can change the whole graph, and events can be frequent
+  enough that compiling nodes no candidate visits before the next one
+  would cost more than the table saves.  Once compiled, a state doesn't
+  change until the Graph clears the table, which it does whenever its
+  nodes change.  Each clearing starts a new generation, which nodes in
+  the table record, so a node's ID can be checked cheaply for
+  staleness.
+
+  Nodes which have left the graph, but are still held by candidates,
+  are never given a state; candidates at such nodes walk the Node itself.
+
+  Tables are not serialized, since they can be rebuilt from the graph.
+*/
+
+class Graph_Table {
+
+public:
+
+  typedef int State_ID;
+  static const State_ID NO_STATE = -1; //!< ID of the empty node, or of a node not in the table
+
+  struct State {
+    Node * node;         //!< node this state was compiled from
+    bool compiled;       //!< have the remaining fields been filled in?
+    bool unique;         //!< Node::is_unique()
+    Phase phase;         //!< phase of tag if the node is unique; else BOGUS_PHASE
+    Tag * tag;           //!< Node::get_tag() if the node is unique; else BOGUS_TAG
+    Gap min_age;         //!< Node::get_min_age()
+    Gap max_age;         //!< Node::get_max_age()
+    unsigned first_edge; //!< index of this state's first edge in cuts and next
+    unsigned num_edges;  //!< number of edges from this state
+    unsigned first_periodic; //!< index of this state's first periodic edge in periodic
+    unsigned num_periodic;   //!< number of periodic edges to test where this state's edges lead nowhere
+    unsigned first_bucket;   //!< index of this state's first bucket in buckets
+    unsigned num_buckets;    //!< number of buckets for this state's edges; 0 if they are found by binary search
+    Gap bucket_lo;           //!< as in Node
+    Gap bucket_scale;        //!< as in Node
+  };
+
+  struct Periodic {
+    const Periodic_Edge * edge; //!< a periodic edge of the state's node
+    State_ID next;              //!< state reached through it
+  };
+
+  Graph_Table();
+
+  void clear(); //!< drop all states, because the graph has changed
+
+  unsigned get_gen() const { return gen; }; //!< generation of this table
+
+  State_ID id_of(Node * n); //!< ID of node n, adding a state for it if necessary; NO_STATE if n is not part of the graph
+
+  const State & state(State_ID s) { if (! states[s].compiled) compile(s); return states[s]; }; //!< state with ID s, compiling it if necessary
+
+  State_ID advance(State_ID s, Gap dt); //!< like Node::advance, but from and to state IDs
+
+protected:
+
+  unsigned gen;                   //!< generation of this table
+  std::vector < State > states;   //!< states, indexed by ID
+  std::vector < Gap > cuts;       //!< gaps at which each state's edges start, in increasing order within a state
+  std::vector < State_ID > next;  //!< next[i] is the state reached by gaps in [cuts[i], cuts[i + 1]) within a state
+  std::vector < Periodic > periodic; //!< periodic edges of each state, in a single run per state
+  std::vector < unsigned > buckets;  //!< buckets of each state, in a single run per state, indexing that state's edges
+
+  static unsigned last_gen;       //!< generation of most recently cleared table, across all graphs
+
+  void compile(State_ID s); //!< fill in state s from its node
+};
+
+#endif // GRAPH_TABLE_HPP
@@ -1,11 +1,14 @@
 #include "Lotek_Data_Source.hpp"
-#include <sstream>
 #include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <functional>
 
 Lotek_Data_Source::Lotek_Data_Source(DB_Filer * db, Tag_Database *tdb, Frequency_MHz defFreq, int bootnum) :
   db(db),
   done(false),
   sgbuf(),
+  sgbuf_seq(0),
   latestInputTS(0),
   bootnum(bootnum)
 {
@@ -26,6 +29,8 @@ Lotek_Data_Source::Lotek_Data_Source(DB_Filer * db, Tag_Database *tdb, Frequency
 
   antFreq = std::vector < Frequency_MHz > ( MAX_ANTENNAS, defFreq);
 
+  sgbuf.reserve(SGBUF_INITIAL_CAPACITY);
+
   // start the db reader
   db->start_DTAtags_reader(0, bootnum);
 
@@ -43,46 +48,128 @@ Lotek_Data_Source::getInputLine() {
  };
 
 bool
-Lotek_Data_Source::getline(char * buf, int maxLen) {
+Lotek_Data_Source::get_record(SG_Record & r) {
 
   for(;;) {
     // wait until either the true input is done, or
-    // we have sufficiently old data in sgbuf (i.e. lines which
+    // we have sufficiently old data in sgbuf (i.e. records which
     // are old enough to be guaranteed (by the value of MAX_LEAD_SECONDS)
     // that no older data will be generated from subsequent input records
-    auto i = sgbuf.begin();
-    if (i != sgbuf.end() && i->first + MAX_LEAD_SECONDS <= latestInputTS) {
-      // easy case - there's a sufficiently old line in the buffer
-      strncpy(buf, i->second.c_str(), maxLen);
-#ifdef DEBUG
-      std::cerr << i->second << std::endl;
-#endif
-      sgbuf.erase(i);
+    if (sgbuf.size() > 0 && sgbuf.front().key + MAX_LEAD_SECONDS <= latestInputTS) {
+      // easy case - there's a sufficiently old record in the buffer
+      const Pending & p = sgbuf.front();
+      r.type = p.type;
+      r.ts = p.ts;
+      r.port = p.port;
+      switch (p.type) {
+      case SG_Record::PULSE:
+        r.v.dfreq = p.x;
+        r.v.sig = p.y;
+        r.v.noise = p.z;
+        break;
+      case SG_Record::GPS:
+        r.v.lat = p.x;
+        r.v.lon = p.y;
+        r.v.alt = p.z;
+        break;
+      case SG_Record::PARAM:
+        // make frequency setting record like: S,1366227448.192,5,-m,166.376,0,
+        strcpy(r.v.param_flag, "-m");
+        r.v.param_value = p.x;
+        r.v.return_code = 0;
+        r.v.error[0] = '\0';
+        break;
+      default:
+        break;
+      }
+      std::pop_heap(sgbuf.begin(), sgbuf.end(), std::greater < Pending > ());
+      sgbuf.pop_back();
       return true;
     }
-    // no lines in sgbuf are sufficiently old.  If there are no true
+    // no records in sgbuf are sufficiently old.  If there are no true
     // input lines left, we're done (we save insufficiently old
-    // sgbuf lines until the next time the algorithm is run with
+    // sgbuf records until the next time the algorithm is run with
     // subsequent data, because there might be pulses from there
     // which precede some of those in the current sgbuf.
 
     if (done)
       return false;
 
-    // typical case; no sufficiently old lines left in sgbuf, but we haven't
+    // typical case; no sufficiently old records left in sgbuf, but we haven't
     // reached EOF on input
 
     if (getInputLine())
       translateLine();
 
-    // loop around until eof or a line is found
+    // loop around until eof or a record is found
   }
 };
 
+// Return the value obtained by writing x with std::setprecision(digits)
+// and reading it back, as happened when this source generated SG-format
+// text.
+//
+// When x and the power of ten needed to scale it to an integer are
+// exactly representable, we round the exact product x * 10^k to an
+// integer (ties to even, as printf does; fma gives the exact residual)
+// and divide by 10^k, which is correctly rounded, as strtod is.
+// Otherwise, we really do format and parse.
+
+static double
+as_printed(double x, int digits) {
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15
+  };
+  double a = fabs(x);
+  if (a >= 1 && a < 1e15 && digits <= 15) {
+    int e = 0;
+    while (pow10[e + 1] <= a)
+      ++e;
+    int k = digits - 1 - e;
+    if (k >= 0) {
+      double s = pow10[k];
+      double n = nearbyint(x * s);
+      double r = fma(x, s, -n);
+      if (r > 0.5 || (r == 0.5 && fmod(n, 2) != 0))
+        n += 1;
+      else if (r < -0.5 || (r == -0.5 && fmod(n, 2) != 0))
+        n -= 1;
+      return n / s;
+    }
+  }
+  if (! std::isfinite(x) || x == 0)
+    return x;
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*g", digits, x);
+  return strtod(buf, 0);
+};
+
+void
+Lotek_Data_Source::add_record(SG_Record::Type type, double x, double y, double z) {
+  Pending p;
+  p.key = dtar.ts;
+  p.seq = sgbuf_seq++;
+  p.type = type;
+  p.ts = as_printed(dtar.ts, 14);
+  p.port = dtar.ant;
+  p.x = x;
+  p.y = y;
+  p.z = z;
+  sgbuf.push_back(p);
+  std::push_heap(sgbuf.begin(), sgbuf.end(), std::greater < Pending > ());
+};
+
+void
+Lotek_Data_Source::add_pulse(Frequency_Offset_kHz dfreq, double sig, SignaldB noise) {
+  // the pulse sig value is read as a float
+  add_record(SG_Record::PULSE, dfreq, (SignaldB) as_printed(sig, 3), noise);
+};
+
 void
 Lotek_Data_Source::translateLine()
 {
-  // add appropriate SG lines to the buffer for a given Lotek line
+  // add appropriate SG records to the buffer for a given Lotek line
   // The lotek line is in components of class field dtar
   //
   // Algorithm: if the current tag detection frequency does not match the
@@ -99,22 +186,13 @@ Lotek_Data_Source::translateLine()
 
   // output a GPS fix, if the tag record has valid lat and lon; DTA files don't report altitude, so report as nan
   if (!(std::isnan(dtar.lat) || std::isnan(dtar.lon))) {
-    /* a GPS fix line like:
-       G,1458001712,44.34021,-66.118733333,21.6
-    */
-    std::ostringstream gpsRec;
-    gpsRec << "G," << std::setprecision(14) << dtar.ts << std::setprecision(8) << "," << dtar.lat << "," << dtar.lon << ",nan";
-    sgbuf.insert(std::make_pair(dtar.ts, gpsRec.str()));
+    add_record(SG_Record::GPS, as_printed(dtar.lat, 8), as_printed(dtar.lon, 8), std::numeric_limits < double > :: quiet_NaN());
   }
 
   latestInputTS = dtar.ts;
   if (dtar.freq != antFreq[dtar.ant + 1]) {
     antFreq[dtar.ant + 1] = dtar.freq;
-    std::ostringstream freqRec;
-    // make frequency setting record like: S,1366227448.192,5,-m,166.376,0,
-
-    freqRec << "S," << std::setprecision(14) << dtar.ts << std::setprecision(6) << "," << dtar.ant << ",-m," << dtar.freq << ",0,";
-    sgbuf.insert(std::make_pair(dtar.ts, freqRec.str()));
+    add_record(SG_Record::PARAM, as_printed(dtar.freq, 6), 0, 0);
   }
 
   bool validTag = dtar.id != 999;
@@ -137,9 +215,7 @@ Lotek_Data_Source::translateLine()
     // records activity on this antenna at this time.  We use values of -999
     // (effectively sentinels) for dfreq, sig, and noise, to make sure
     // this pulse doesn't end up as part of any real detection.
-    std::ostringstream pRec;
-    pRec << "p" << dtar.ant << "," << std::setprecision(14) << dtar.ts << std::setprecision(3) << ",-999,-999,-999";
-    sgbuf.insert(std::make_pair(dtar.ts, pRec.str()));
+    add_pulse(-999, -999, -999);
     return;
   }
 
@@ -147,12 +223,9 @@ Lotek_Data_Source::translateLine()
   // generate a record for each tag pulse
 
   for(auto i = gg->begin(); i != gg->end(); ++i) {
-    std::ostringstream pRec;
-    // "%hd,%lf,%f,%f,%f", &port_num, &ts, &dfreq, &sig, &noise)) {
     // we use dfreq=4 to put it at the usual nominal SG frequency (i.e. funcube is tuned 4 kHz
     // below nominal, so dfreq=4 means a tag on nominal)
-    pRec << "p" << dtar.ant << "," << std::setprecision(14) << dtar.ts << std::setprecision(3) << ",4," << dtar.sig << ",-96";
-    sgbuf.insert(std::make_pair(dtar.ts, pRec.str()));
+    add_pulse(4, dtar.sig, -96);
     dtar.ts += *i; // NB: the last gap takes us to the next burst, so is not actually used
   }
 }
@@ -166,13 +239,14 @@ Lotek_Data_Source::rewind() {
 // properly with templates.
 
 // Note: we only serialize what's needed to resume
-// processing buffered lines.  Tcode will be reconstructed
+// processing buffered records.  Tcode will be reconstructed
 // from the tag database provided, as we don't want
 // to be saving another copy of tag signatures (and the
 // copy saved might be saved with motus in the future).
 
 #define SERIALIZE_FUN_BODY \
    ar & BOOST_SERIALIZATION_NVP( sgbuf );                       \
+   ar & BOOST_SERIALIZATION_NVP( sgbuf_seq );                   \
    ar & BOOST_SERIALIZATION_NVP( latestInputTS );               \
    ar & BOOST_SERIALIZATION_NVP( antFreq );                     \
    ar & BOOST_SERIALIZATION_NVP( warned );
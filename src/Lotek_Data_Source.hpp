@@ -40,6 +40,11 @@
 // We opt for B, because then the detection dataset will ultimately
 // be correct, even if it is not fully delivered on the most convenient
 // schedule.
+//
+// Output is provided as SG_Records, via get_record(), rather than as
+// lines of SG-format text.  Values are rounded to the precision with
+// which they used to be written into that text, so that results are
+// unchanged.
 
 
 //!< Source for Lotek-format input data.
@@ -50,7 +55,7 @@
 #include "Tag_Candidate.hpp"
 #include <map>
 #include <unordered_set>
-#include <boost/serialization/map.hpp>
+#include <boost/serialization/utility.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/set.hpp>
 
@@ -58,7 +63,7 @@ class Lotek_Data_Source : public Data_Source {
 
 public:
   Lotek_Data_Source(DB_Filer * db, Tag_Database *tdb, Frequency_MHz defFreq, int bootnum=0);
-  bool getline(char * buf, int maxLen);
+  bool get_record(SG_Record & r); //!< get the next SG record generated from Lotek detections
   static const int MAX_LOTEK_LINE_SIZE = 100;
   static const int MAX_LEAD_SECONDS = 10;  //!< maximum number of
                                          //! seconds before we dump
@@ -76,7 +81,39 @@ protected:
   typedef std::map < std::pair < short , short > , std::vector < Gap > * > tcode_t; //!< type of a map from (codeset, ID) to pulse gaps
   tcode_t tcode;                                                          //!< populated from the Lotek tag databse.
   bool done;                                                              //!< true if input stream is finished
-  std::multimap < double, std::string > sgbuf;                            //!< buffer of SG-format lines
+
+  //!< a record waiting in sgbuf; a compact, fixed-size form of the
+  // few kinds of SG_Record this source generates
+  struct Pending {
+    Timestamp key;           //!< unrounded detection timestamp; records are released in order of this
+    unsigned long long seq;  //!< order of insertion, so that records with equal keys are released first-in, first-out
+    SG_Record::Type type;    //!< PULSE, GPS, or PARAM (a frequency setting)
+    Timestamp ts;            //!< record timestamp
+    Port_Num port;           //!< antenna
+    double x, y, z;          //!< PULSE: dfreq, sig, noise; GPS: lat, lon, alt; PARAM: frequency in MHz
+
+    bool operator> (const Pending & p) const {
+      return key > p.key || (key == p.key && seq > p.seq);
+    };
+
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+      ar & BOOST_SERIALIZATION_NVP( key );
+      ar & BOOST_SERIALIZATION_NVP( seq );
+      ar & BOOST_SERIALIZATION_NVP( type );
+      ar & BOOST_SERIALIZATION_NVP( ts );
+      ar & BOOST_SERIALIZATION_NVP( port );
+      ar & BOOST_SERIALIZATION_NVP( x );
+      ar & BOOST_SERIALIZATION_NVP( y );
+      ar & BOOST_SERIALIZATION_NVP( z );
+    };
+  };
+
+  static const int SGBUF_INITIAL_CAPACITY = 4096; //!< records for which space is reserved in sgbuf; it only grows beyond this if a large time reversal makes many records wait
+
+  std::vector < Pending > sgbuf;                                          //!< min-heap of buffered records, ordered by (key, seq)
+  unsigned long long sgbuf_seq;                                           //!< sequence number for next record added to sgbuf
   Timestamp latestInputTS;                                                //!< timestamp of most recent input line
   std::vector < Frequency_MHz > antFreq;                                  //!< most recent listen frequency on each antenna, in MHz
   std::set < std::pair < short, short > > warned;                         //!< sets of tag/codeset combos for which 'non-existent' warning has been issued
@@ -91,6 +128,10 @@ protected:
 
   void translateLine(); //!< translate the line into zero or more SG-style records; return true if any records generated
 
+  void add_pulse(Frequency_Offset_kHz dfreq, double sig, SignaldB noise); //!< buffer a pulse record at the current detection's antenna and timestamp
+
+  void add_record(SG_Record::Type type, double x, double y, double z); //!< add a record for the current detection to sgbuf
+
   void serialize(boost::archive::binary_iarchive & ar, const unsigned int version);
   void serialize(boost::archive::binary_oarchive & ar, const unsigned int version);
 
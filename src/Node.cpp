@@ -5,6 +5,15 @@
 #include "Ambiguity.hpp"
 #include <cmath>
 
+void
+Node::setSet(Set * ns) {
+  if (journal && tcUseCount > 0 && ns != s)
+    journal->push_back(Change {this, is_unique(), get_tag(), min_age});
+  ns->acquire();
+  s->release();
+  s = ns;
+};
+
 void
 Node::link() {
   ++ useCount;
@@ -42,8 +51,7 @@ Node::drop() {
     return;
   if (tcUseCount != 0)
     return;
-  if (s != Set::empty())
-    delete s;
+  s->release();
   -- _numNodes;
   delete this;
 };
@@ -55,28 +63,131 @@ Node::advance (Gap dt) {
   // those tag IDs which are compatible with the current set of pulses and with
   // the specified gap to the next pulse.
 
-  // get the point at or left of the given gap
+  Node * m = next[find_cut(& cuts[0], cuts.size(), buckets.data(), buckets.size(), bucket_lo, bucket_scale, dt)];
+  if (m != _empty)
+    return m;
 
-  auto i = e.upper_bound(dt);
-  --i;
-  if (i->second != _empty)
-    return i->second;
+  // periodic edges only lead anywhere where e leads to the empty node
+  for (size_t i = 0; i < num_scanned; ++i)
+    if (pe[i].match(dt))
+      return pe[i].target != _empty ? pe[i].target : 0;
   return 0;
 };
 
+void
+Node::bucket() {
+  // Gap_Range rounds the ends of edges to multiples of the graph's
+  // tolerance, so the narrowest finite edge is usually that wide, and
+  // the buckets span the finite cuts in steps of it.  A node whose
+  // edges are too narrow or too spread out for that to be worth the
+  // memory keeps using the binary search.
+
+  buckets.clear();
+  size_t n = cuts.size();
+  if (n < MIN_BUCKETED_CUTS)
+    return;
+  Gap w = 1.0 / 0.0;
+  for (size_t i = 2; i < n - 1; ++i)
+    w = std::min(w, cuts[i] - cuts[i - 1]);
+  Gap span = cuts[n - 2] - cuts[1];
+  if (! (w > 0 && span / w < MAX_BUCKETS_PER_CUT * n))
+    return;
+  bucket_lo = cuts[1];
+  bucket_scale = 1 / w;
+  buckets.resize((size_t) (span * bucket_scale) + 1);
+  size_t i = 1;
+  for (size_t b = 0; b < buckets.size(); ++b) {
+    Gap start = bucket_lo + b * w;
+    while (cuts[i + 1] <= start)
+      ++i;
+    buckets[b] = i;
+  }
+};
+
+void
+Node::compile() {
+  if (journal && tcUseCount > 0)
+    journal->push_back(Change {this, is_unique(), get_tag(), min_age});
+  stale = false;
+  cuts.clear();
+  next.clear();
+  num_scanned = pe.size();
+  if (num_scanned <= MAX_SCANNED_PERIODIC) {
+    cuts.reserve(e.size());
+    next.reserve(e.size());
+    for (auto i = e.begin(); i != e.end(); ++i) {
+      cuts.push_back(i->first);
+      next.push_back(i->second);
+    }
+  } else {
+    // overlay the live occurrences of periodic edges on a copy of e;
+    // they lie where e leads to the empty node, and those of different
+    // edges don't overlap, so only a family's own occurrences can
+    Edges f(e);
+    std::vector < int > ks;
+    for (auto & p : pe) {
+      ks.clear();
+      p.overlapping(- 1.0 / 0.0, 1.0 / 0.0, ks);
+      for (size_t j = 0; j < ks.size(); /**/) {
+        Gap_Range r = p.range(ks[j]);
+        for (++j; j < ks.size() && p.range(ks[j]).first < r.second; ++j)
+          r.second = std::max(r.second, p.range(ks[j]).second);
+        auto i = f.upper_bound(r.second);
+        Node * after = (--i)->second;
+        f.erase(f.lower_bound(r.first), f.lower_bound(r.second));
+        f[r.first] = p.target;
+        f.insert(std::make_pair(r.second, after));
+      }
+    }
+    cuts.reserve(f.size());
+    next.reserve(f.size());
+    for (auto i = f.begin(); i != f.end(); ++i) {
+      cuts.push_back(i->first);
+      next.push_back(i->second);
+    }
+    num_scanned = 0;
+  }
+  bucket();
+
+  // the ages are at the finite ends of the edges inside (-Inf, Inf),
+  // and of the periodic edges
+  bool any = e.size() > 2;
+  min_age = max_age = 0;
+  if (any) {
+    auto first = e.begin(), last = e.end();
+    ++first;
+    --last;
+    --last;
+    min_age = std::isfinite(first->first) ? first->first : 0;
+    max_age = std::isfinite(last->first) ? last->first : 0;
+  }
+  for (auto & p : pe) {
+    if (! any || p.min_gap() < min_age)
+      min_age = p.min_gap();
+    if (! any || p.max_gap() > max_age)
+      max_age = p.max_gap();
+    any = true;
+  }
+};
 
 void
 Node::ctorCommon() {
   useCount = 0;
   tcUseCount = 0;
+  cands = 0;
   _valid = true;
   stamp = 0;
   label = maxLabel++;
+  table_gen = 0;
+  table_id = -1;
+  bucket_lo = 0;
+  bucket_scale = 0;
   ++ _numNodes;
   if (_empty) {
     e.insert(std::make_pair(-1.0 / 0.0, _empty));
     e.insert(std::make_pair( 1.0 / 0.0, _empty));
   }
+  compile();
 };
 
 void
@@ -94,10 +205,14 @@ Node::Node() : s(Set::empty()), e() {
   ctorCommon();
 };
 
-Node::Node(const Node *n) : s(n->s), e(n->e), useCount(0) {
+Node::Node(const Node *n) : s(n->s), e(n->e), pe(n->pe), useCount(0) {
   ctorCommon();
+  s->acquire();
   for (auto i = e.begin(); i != e.end(); ++i)
     i->second->link();
+  for (auto & p : pe)
+    for (int k = p.num_live(); k > 0; --k)
+      p.target->link();
 };
 
 int
@@ -120,24 +235,6 @@ Node::is_unique() {
 };
 
 
-Gap
-Node::get_max_age() {
-  auto i = e.rbegin();
-  ++i;
-  if (std::isfinite(i->first))
-    return i->first;
-  return 0;
-};
-
-Gap
-Node::get_min_age() {
-  auto i = e.begin();
-  ++i;
-  if (std::isfinite(i->first))
-    return i->first;
-  return 0;
-};
-
 Tag *
 Node::get_tag() {
   if (s == Set::empty())
@@ -163,6 +260,12 @@ Node::dump(bool skipEdges) {
       i->second->s->dump();
       std::cout << std::endl;
     }
+    for (auto & p : pe) {
+      std::cout << "   " << p.count << " x (" << p.base << " + k * " << p.period << " + " << p.shift << "), " << p.materialized.size()
+                << " materialized -> Node (" << p.target->label << ", uc=" << p.target->useCount << ") for Set ";
+      p.target->s->dump();
+      std::cout << std::endl;
+    }
   }
 };
 
@@ -174,4 +277,5 @@ Node::valid () {
 int Node::_numNodes = 0;
 int Node::_numLinks = 0;
 int Node::maxLabel = 0;
+Node::Journal * Node::journal = 0;
 Node * Node::_empty = 0;
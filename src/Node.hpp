@@ -7,31 +7,83 @@
 #include "find_tags_common.hpp"
 #include "Tag.hpp"
 #include "Set.hpp"
+#include "Periodic_Edge.hpp"
+
+class Tag_Candidate;
 
 class Node {
 
   friend class Graph;
   friend class Tag_Finder;
   friend class Tag_Foray;
+  friend class Graph_Table;
+  friend class Tag_Candidate;
 
   typedef std::map < Gap, Node * > Edges;
+  typedef std::vector < Periodic_Edge > Periodic_Edges;
 
 protected:
   Set * s;  //!< set of tag phases at this node
   Edges e;  //!< edges to other nodes
+  Periodic_Edges pe; //!< families of edges repeating with a tag's period; each live occurrence counts as a link to its target
   int useCount; //!< number of nodes linking to this one
   int tcUseCount; //!< number of Tag_Candidates pointing to this state
+  Tag_Candidate * cands; //!< first of the Tag_Candidates at this state, linked through their node_next; rebuilt after deserialization
   bool _valid;  //!< true iff this node is part of a graph
   int label; //!< unique label for this node, during run
 
+  // e, flattened for advance(); rebuilt by compile() whenever e changes
+  std::vector < Gap > cuts;     //!< gaps at which edges start, in increasing order
+  std::vector < Node * > next;  //!< next[i] is the node reached by gaps in [cuts[i], cuts[i+1])
+  size_t num_scanned;           //!< number of periodic edges advance() must test; 0 if they've been flattened too
+  bool stale;                   //!< have e or pe changed since the last compile()?  Only while a Graph defers compiling
+  std::vector < unsigned > buckets; //!< for a node with many edges, buckets[b] is the index of the last cut at or below bucket_lo + b / bucket_scale; else empty
+  Gap bucket_lo;                //!< gap at which the first bucket starts
+  Gap bucket_scale;             //!< buckets per second of gap
+  Gap min_age;                  //!< value of get_min_age()
+  Gap max_age;                  //!< value of get_max_age()
+
+  unsigned table_gen;           //!< generation of the last Graph_Table to include this node
+  int table_id;                 //!< state ID of this node in that Graph_Table
 
   static int _numNodes;  //!< number of allocated nodes not yet deleted
   static int _numLinks; //!< number of links between nodes
   static int maxLabel; //!< max label value
   static Node * _empty; //!< pointer to unique node representing empty tag phase set
 
+public:
+  //!< a node holding tag candidates, with its uniqueness, tag and
+  // min age from before setSet changed its set or compile its edges
+  struct Change {
+    Node * n;
+    bool unique;
+    Tag * tag;
+    Gap min_age;
+  };
+  typedef std::vector < Change > Journal;
+  static Journal * journal; //!< if not 0, setSet and compile append a Change for each node holding tag candidates which they change
+
+protected:
+
+  // a node with more periodic edges than this has them flattened
+  // along with e, since a binary search then beats testing each
+  static const size_t MAX_SCANNED_PERIODIC = 4;
+
+  // a node with at least this many cuts gets buckets, so long as
+  // that takes no more than MAX_BUCKETS_PER_CUT buckets per cut
+  static const size_t MIN_BUCKETED_CUTS = 32;
+  static const size_t MAX_BUCKETS_PER_CUT = 16;
+
   void ctorCommon(); //!< common ctor code
 
+  void bucket(); //!< rebuild buckets from cuts
+
+  //!< index of the last of n cuts at or below dt, where the first
+  // cut is -Inf, using num_buckets buckets built by bucket() for
+  // those cuts, if there are any, and otherwise a binary search;
+  // shared with Graph_Table, which keeps its own copies of the arrays
+  static size_t find_cut(const Gap * cuts, size_t n, const unsigned * buckets, size_t num_buckets, Gap lo, Gap scale, Gap dt);
+
 public:
 
   bool is_unique(); //!< true if only a single tag ID (possibly in multiple phases) is represented here
@@ -40,9 +92,9 @@ public:
   //node, and resetting across all nodes at the start of each recursive algorithm, except when the
   // stamp value has wrapped.
 
-  Gap get_max_age();  //!< maximum gap value for which there's an edge to another node
+  Gap get_max_age() { return max_age; };  //!< maximum gap value for which there's an edge to another node
 
-  Gap get_min_age();  //!< minimum gap value for which there's an edge to another node
+  Gap get_min_age() { return min_age; };  //!< minimum gap value for which there's an edge to another node
 
   Phase get_phase(); //!< return the phase for the (presumed unique) tag int his set
   Tag * get_tag(); //!< return the (presumed unique) tag in the set for this node
@@ -53,10 +105,15 @@ public:
 
   Node(const Node *n); //!< pointer copy ctor
 
+  void setSet(Set * ns); //!< make ns the set of tag phases at this node, in place of s
+
   void link(); //!< indicate a link into node is added
   bool unlink();//!< indicate a link into node is removed
   void drop(); //!< remove this node
   Node * advance (Gap dt); //!< move to the next node, given a gap
+  void compile(); //!< rebuild the flattened edges and cached ages from e; call after changing e
+  const Edges & edges() const { return e; }; //!< edges to other nodes
+  const Periodic_Edges & periodic_edges() const { return pe; }; //!< periodic edges to other nodes, for gaps where edges() leads to the empty node
 
   static Node * empty(); //!< return unique node for empty set
   static int numNodes(); //!< return number of nodes allocated but not deleted
@@ -70,12 +127,44 @@ public:
   void serialize(Archive & ar, const unsigned int version) {
     ar & BOOST_SERIALIZATION_NVP( s );
     ar & BOOST_SERIALIZATION_NVP( e );
+    ar & BOOST_SERIALIZATION_NVP( pe );
     ar & BOOST_SERIALIZATION_NVP( useCount );
     ar & BOOST_SERIALIZATION_NVP( tcUseCount );
     ar & BOOST_SERIALIZATION_NVP( _valid );
     ar & BOOST_SERIALIZATION_NVP( label );
+    if (Archive::is_loading::value)
+      compile();
   };
 
 };
 
+inline size_t
+Node::find_cut(const Gap * cuts, size_t n, const unsigned * buckets, size_t num_buckets, Gap lo, Gap scale, Gap dt) {
+  // find the last edge starting at or left of the given gap; the
+  // first starts at -Inf, so there always is one.
+
+  // a bucket is no wider than the narrowest edge, so at most one cut
+  // follows its first; the backward step is only for rounding in x
+  // (a NaN x fails the test, and gets the binary search)
+  Gap x = (dt - lo) * scale;
+  if (x >= 0 && x < num_buckets) {
+    size_t i = buckets[(size_t) x];
+    while (cuts[i + 1] <= dt)
+      ++i;
+    while (cuts[i] > dt)
+      --i;
+    return i;
+  }
+
+  // This binary search has no data-dependent branches, so it doesn't
+  // stall on mispredictions.
+  const Gap * c = cuts;
+  while (n > 1) {
+    size_t half = n / 2;
+    c = (c[half] <= dt) ? c + half : c;
+    n -= half;
+  }
+  return c - cuts;
+};
+
 #endif // NODE_HPP
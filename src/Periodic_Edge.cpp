@@ -0,0 +1,89 @@
+#include "Periodic_Edge.hpp"
+
+#include <algorithm>
+
+Periodic_Edge::Periodic_Edge() :
+  base(0),
+  period(1),
+  shift(0),
+  tol(0),
+  timeFuzz(0),
+  count(0),
+  materialized(),
+  target(0)
+{
+};
+
+Periodic_Edge::Periodic_Edge(Gap base, Gap period, Gap shift, Gap tol, float timeFuzz, Gap maxTime) :
+  base(base),
+  period(period),
+  shift(shift),
+  tol(tol),
+  timeFuzz(timeFuzz),
+  count(0),
+  materialized(),
+  target(0)
+{
+  while (base + count * period < maxTime)
+    ++count;
+};
+
+bool
+Periodic_Edge::is_live(int k) const {
+  return ! std::binary_search(materialized.begin(), materialized.end(), k);
+};
+
+void
+Periodic_Edge::materialize(int k) {
+  auto i = std::lower_bound(materialized.begin(), materialized.end(), k);
+  if (i == materialized.end() || *i != k)
+    materialized.insert(i, k);
+};
+
+void
+Periodic_Edge::candidates(Gap lo, Gap hi, int & k0, int & k1) const {
+  // Gap_Range widens g by at most max(tol, |g| * timeFuzz), then
+  // rounds outward to a multiple of tol; allow one more occurrence
+  // on each side for rounding in the division
+
+  Gap c0 = base + shift;
+  Gap g = std::max(fabs(c0), fabs(c0 + (count - 1) * period));
+  Gap reach = std::max(tol, g * timeFuzz) + tol;
+  double a = floor((lo - reach - c0) / period) - 1;
+  double b = ceil ((hi + reach - c0) / period) + 1;
+  k0 = a < 0 ? 0 : a > count ? count : (int) a;
+  k1 = b > count - 1 ? count - 1 : b < -1 ? -1 : (int) b;
+};
+
+bool
+Periodic_Edge::match(Gap dt) const {
+  int k0, k1;
+  candidates(dt, dt, k0, k1);
+  for (int k = k0; k <= k1; ++k) {
+    Gap_Range r = range(k);
+    if (r.first <= dt && dt < r.second && is_live(k))
+      return true;
+  }
+  return false;
+};
+
+void
+Periodic_Edge::overlapping(Gap lo, Gap hi, std::vector < int > & ks) const {
+  int k0, k1;
+  candidates(lo, hi, k0, k1);
+  for (int k = k0; k <= k1; ++k) {
+    Gap_Range r = range(k);
+    if (r.first < hi && lo < r.second && is_live(k))
+      ks.push_back(k);
+  }
+};
+
+Gap
+Periodic_Edge::min_gap() const {
+  return range(0).first;
+};
+
+Gap
+Periodic_Edge::max_gap() const {
+  return range(count - 1).second;
+};
@@ -0,0 +1,73 @@
+#ifndef PERIODIC_EDGE_HPP
+#define PERIODIC_EDGE_HPP
+
+#include "find_tags_common.hpp"
+#include "Gap_Range.hpp"
+
+class Node;
+
+/*
+  Periodic_Edge - a family of edges out of a Node, one for each
+  multiple of a tag's period, all leading to the same Node.
+
+  Occurrence k, for 0 <= k < count, is the Gap_Range centred at
+  base + k * period + shift, with tolerance tol and timeFuzz, so the
+  family stands for the edges Graph::_addTag used to add one by one
+  for back and skip edges.  Whether a gap is in a live occurrence is
+  found by dividing by the period, so neither the memory nor the time
+  taken by a family depends on how many occurrences it has.
+
+  Occurrences of a family never overlap an edge to a non-empty node,
+  nor a live occurrence of another family at the same node; the Graph
+  inserts any which would as ordinary edges instead.  Such occurrences
+  are listed in materialized.
+*/
+
+struct Periodic_Edge {
+  Gap base;      //!< gap of the first occurrence, before shift
+  Gap period;    //!< gap between occurrences
+  Gap shift;     //!< offset of all occurrences (for clock jumps)
+  Gap tol;       //!< tolerance for each occurrence, as in Gap_Range
+  float timeFuzz; //!< fractional timing slop for each occurrence, as in Gap_Range
+  int count;     //!< number of occurrences
+  std::vector < int > materialized; //!< occurrences which are ordinary edges instead, in increasing order
+  Node * target; //!< node reached through any live occurrence
+
+  Periodic_Edge();
+
+  //!< occurrences at base + k * period + shift, for all k >= 0 with base + k * period < maxTime
+  Periodic_Edge(Gap base, Gap period, Gap shift, Gap tol, float timeFuzz, Gap maxTime);
+
+  Gap_Range range(int k) const { return Gap_Range(base + k * period + shift, tol, timeFuzz); }; //!< gaps in occurrence k
+
+  bool is_live(int k) const; //!< is occurrence k still part of this family?
+
+  int num_live() const { return count - materialized.size(); }; //!< number of occurrences still part of this family
+
+  void materialize(int k); //!< drop occurrence k, which the caller is adding as an ordinary edge
+
+  bool match(Gap dt) const; //!< is dt in a live occurrence?
+
+  void overlapping(Gap lo, Gap hi, std::vector < int > & ks) const; //!< append live occurrences overlapping [lo, hi) to ks, in increasing order
+
+  Gap min_gap() const; //!< smallest gap in any occurrence
+  Gap max_gap() const; //!< gap at which the last occurrence ends
+
+  template < class Archive >
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & BOOST_SERIALIZATION_NVP( base );
+    ar & BOOST_SERIALIZATION_NVP( period );
+    ar & BOOST_SERIALIZATION_NVP( shift );
+    ar & BOOST_SERIALIZATION_NVP( tol );
+    ar & BOOST_SERIALIZATION_NVP( timeFuzz );
+    ar & BOOST_SERIALIZATION_NVP( count );
+    ar & BOOST_SERIALIZATION_NVP( materialized );
+    ar & BOOST_SERIALIZATION_NVP( target );
+  };
+
+protected:
+
+  void candidates(Gap lo, Gap hi, int & k0, int & k1) const; //!< range [k0, k1] of occurrences which might overlap [lo, hi]
+};
+
+#endif // PERIODIC_EDGE_HPP
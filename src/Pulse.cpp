@@ -6,7 +6,9 @@ Pulse::Pulse() :
   ant_freq(0),
   sig(0),
   noise(0),
-  seq_no(0)
+  seq_no(0),
+  sig_lin(linear_power(0)),
+  noise_lin(linear_power(0))
 {};
 
 Pulse::Pulse(double ts, Frequency_Offset_kHz dfreq, float sig, float noise, Frequency_MHz ant_freq):
@@ -14,7 +16,9 @@ Pulse::Pulse(double ts, Frequency_Offset_kHz dfreq, float sig, float noise, Freq
   dfreq(dfreq),
   ant_freq(ant_freq),
   sig(sig),
-  noise(noise)
+  noise(noise),
+  sig_lin(linear_power(sig)),
+  noise_lin(linear_power(noise))
 { 
   this->seq_no = ++count;
 };
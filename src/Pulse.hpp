@@ -28,6 +28,12 @@ public:
 
   Seq_No	        seq_no;     
 
+  // sig and noise as linear power, for averaging over bursts; computed
+  // once, when the pulse is made, rather than for each burst it is in
+
+  float			sig_lin;	// 10 ^ (sig / 10)
+  float			noise_lin;	// 10 ^ (noise / 10)
+
   static Seq_No         count;
 
 private:
@@ -38,6 +44,8 @@ public:
 
   static Pulse make(double ts, Frequency_Offset_kHz dfreq, float sig, float noise, Frequency_MHz ant_freq);
 
+  static float linear_power(float dB) { return powf(10.0, dB / 10.0); }; //!< power ratio for a level in dB
+
   void dump();
 
   template < class Archive >
@@ -48,6 +56,10 @@ public:
     ar & BOOST_SERIALIZATION_NVP( sig );
     ar & BOOST_SERIALIZATION_NVP( noise );
     ar & BOOST_SERIALIZATION_NVP( seq_no );
+    if (Archive::is_loading::value) {
+      sig_lin = linear_power(sig);
+      noise_lin = linear_power(noise);
+    }
   };
 
 };
@@ -0,0 +1,243 @@
+#include "Pulse_History.hpp"
+
+#include "Slab_Pool.hpp"
+
+Pulse_History::Link::Link() :
+  prev(0),
+  refs(0),
+  first_child(0),
+  next_sibling(0),
+  prev_sibling(0),
+  next_same(this),
+  prev_same(this),
+  first_holder(0),
+  stamp(0)
+{
+};
+
+void *
+Pulse_History::Link::operator new(size_t size) {
+  // the pool is never destroyed, since links may be released by
+  // static destructors
+  static Slab_Pool * pool = new Slab_Pool(sizeof(Link));
+  return pool->alloc();
+};
+
+void
+Pulse_History::Link::operator delete(void * p) {
+  Slab_Pool::release(p);
+};
+
+void
+Pulse_History::Link::loaded() {
+  add_child(this);
+  auto i = loaded_links.find(pulse.seq_no);
+  if (i == loaded_links.end())
+    loaded_links[pulse.seq_no] = this;
+  else
+    join_same(this, i->second);
+};
+
+Pulse_History::Pulse_History() :
+  holder(0),
+  newest(0),
+  n(0),
+  next_holder(0),
+  prev_holder(0)
+{
+};
+
+Pulse_History::Pulse_History(const Pulse_History & h) :
+  holder(0),
+  newest(h.newest),
+  n(h.n),
+  next_holder(0),
+  prev_holder(0)
+{
+  if (newest) {
+    ++newest->refs;
+    add_holder();
+  }
+};
+
+Pulse_History &
+Pulse_History::operator= (const Pulse_History & h) {
+  if (h.newest)
+    ++h.newest->refs;
+  if (newest) {
+    remove_holder();
+    release(newest);
+  }
+  newest = h.newest;
+  n = h.n;
+  if (newest)
+    add_holder();
+  return *this;
+};
+
+Pulse_History::~Pulse_History() {
+  clear();
+};
+
+void
+Pulse_History::add_holder() {
+  prev_holder = 0;
+  next_holder = newest->first_holder;
+  if (next_holder)
+    next_holder->prev_holder = this;
+  newest->first_holder = this;
+};
+
+void
+Pulse_History::remove_holder() {
+  if (prev_holder)
+    prev_holder->next_holder = next_holder;
+  else
+    newest->first_holder = next_holder;
+  if (next_holder)
+    next_holder->prev_holder = prev_holder;
+  next_holder = prev_holder = 0;
+};
+
+void
+Pulse_History::add_child(Link * l) {
+  Link * p = l->prev;
+  if (! p)
+    return;
+  l->prev_sibling = 0;
+  l->next_sibling = p->first_child;
+  if (l->next_sibling)
+    l->next_sibling->prev_sibling = l;
+  p->first_child = l;
+};
+
+void
+Pulse_History::join_same(Link * l, Link * same) {
+  l->next_same = same->next_same;
+  l->prev_same = same;
+  same->next_same->prev_same = l;
+  same->next_same = l;
+};
+
+void
+Pulse_History::release(Link * l) {
+  // iterative, since histories can be long
+  while (l && --l->refs == 0) {
+    // l has no children or holders, since they would hold references
+    Link * prev = l->prev;
+    if (l->prev_sibling)
+      l->prev_sibling->next_sibling = l->next_sibling;
+    else if (prev)
+      prev->first_child = l->next_sibling;
+    if (l->next_sibling)
+      l->next_sibling->prev_sibling = l->prev_sibling;
+    l->prev_same->next_same = l->next_same;
+    l->next_same->prev_same = l->prev_same;
+    if (last_link == l)
+      last_link = l->next_same != l ? l->next_same : 0;
+    delete l;
+    l = prev;
+  }
+};
+
+void
+Pulse_History::push_back(const Pulse & p) {
+  // the new link takes over this history's reference to newest
+  Link * l = new Link;
+  l->pulse = p;
+  l->prev = newest;
+  l->refs = 1;
+  add_child(l);
+
+  // all candidates accepting a pulse do so while it is being
+  // processed, so other links for this pulse were added just now
+  if (last_link && last_link->pulse.seq_no == p.seq_no)
+    join_same(l, last_link);
+  last_link = l;
+
+  if (newest)
+    remove_holder();
+  newest = l;
+  add_holder();
+  ++n;
+};
+
+void
+Pulse_History::clear() {
+  if (newest) {
+    remove_holder();
+    release(newest);
+  }
+  newest = 0;
+  n = 0;
+};
+
+bool
+Pulse_History::shares_any(const Pulse_History & h) const {
+  // both lists are in decreasing order of seq_no, so merge them that
+  // way; reaching a link common to both means the rest is shared too
+
+  const Link * l1 = newest;
+  const Link * l2 = h.newest;
+
+  while (l1 && l2) {
+    if (l1 == l2)
+      return true;
+    if (l1->pulse.seq_no > l2->pulse.seq_no) {
+      l1 = l1->prev;
+    } else if (l1->pulse.seq_no < l2->pulse.seq_no) {
+      l2 = l2->prev;
+    } else {
+      return true;
+    }
+  }
+  return false;
+};
+
+void
+Pulse_History::get_sharers(std::vector < Tag_Candidate * > & out) const {
+  // A history has a pulse iff its newest link is a descendant of one
+  // of the links for that pulse.  So visit the subtrees below each
+  // link for each of our pulses.  Subtrees below our older links
+  // include those below our newer ones, so stamp links as they are
+  // visited, to visit each only once.
+
+  unsigned stamp = ++last_stamp;
+  static std::vector < Link * > stack;
+  for (Link * l = newest; l; l = l->prev) {
+    Link * s = l;
+    do {
+      if (s->stamp != stamp) {
+        stack.push_back(s);
+        while (! stack.empty()) {
+          Link * d = stack.back();
+          stack.pop_back();
+          d->stamp = stamp;
+          for (Pulse_History * h = d->first_holder; h; h = h->next_holder)
+            out.push_back(h->holder);
+          for (Link * c = d->first_child; c; c = c->next_sibling)
+            if (c->stamp != stamp)
+              stack.push_back(c);
+        }
+      }
+      s = s->next_same;
+    } while (s != l);
+  }
+};
+
+void
+Pulse_History::copy_to(Pulse_Buffer & buf) const {
+  buf.resize(n);
+  size_t i = n;
+  for (const Link * l = newest; l; l = l->prev)
+    buf[--i] = l->pulse;
+};
+
+void
+Pulse_History::end_load() {
+  loaded_links.clear();
+};
+
+Pulse_History::Link * Pulse_History::last_link = 0;
+unsigned Pulse_History::last_stamp = 0;
+std::unordered_map < Pulse::Seq_No, Pulse_History::Link * > Pulse_History::loaded_links;
@@ -0,0 +1,116 @@
+#ifndef PULSE_HISTORY_HPP
+#define PULSE_HISTORY_HPP
+
+#include "find_tags_common.hpp"
+#include "Pulse.hpp"
+
+class Tag_Candidate;
+
+/*
+  Pulse_History - the pulses accepted by a Tag_Candidate, as a
+  persistent list linked from the newest pulse back to the oldest.
+
+  Links are reference counted and never modified once created, so
+  copying a history (as when a Tag_Candidate is cloned) just shares
+  its links, and adding a pulse to one copy adds a link which the
+  other copies don't see.  Candidates cloned from a common ancestor
+  thus share the pulses they accepted before the clone.
+
+  So that the histories sharing a pulse can be found without looking
+  at the others, links also form a tree: each link knows the links
+  whose prev it is, and the histories whose newest link it is.  Links
+  for the same pulse added separately to different histories are
+  joined in a ring.
+
+  Serializing histories through the same archive preserves the
+  sharing, since links are serialized by pointer.  The tree is rebuilt
+  as links are loaded; the rings are rebuilt by end_load().
+*/
+
+class Pulse_History {
+
+public:
+
+  struct Link {
+    Pulse pulse;    //!< pulse accepted
+    Link * prev;    //!< link for the previous pulse; 0 if none
+    unsigned refs;  //!< histories and links pointing to this link
+
+    // not serialized:
+    Link * first_child;           //!< first of the links whose prev is this one
+    Link * next_sibling;          //!< next link with the same prev
+    Link * prev_sibling;          //!< previous link with the same prev
+    Link * next_same;             //!< next link in ring of links for the same pulse
+    Link * prev_same;             //!< previous link in ring of links for the same pulse
+    Pulse_History * first_holder; //!< first of the histories whose newest link this is
+    unsigned stamp;               //!< last search to visit this link
+
+    Link();
+
+    // links are allocated from a slab pool shared by all histories
+    static void * operator new(size_t size);
+    static void operator delete(void * p);
+
+    template < class Archive >
+    void serialize(Archive & ar, const unsigned int version) {
+      ar & BOOST_SERIALIZATION_NVP( pulse );
+      ar & BOOST_SERIALIZATION_NVP( prev );
+      ar & BOOST_SERIALIZATION_NVP( refs );
+      if (Archive::is_loading::value)
+        loaded();
+    };
+
+    void loaded(); //!< attach a just-deserialized link to the tree
+  };
+
+  Pulse_History();
+  Pulse_History(const Pulse_History & h); //!< share h's pulses; the copy has no holder
+  Pulse_History & operator= (const Pulse_History & h);
+  ~Pulse_History();
+
+  Tag_Candidate * holder; //!< candidate this history belongs to
+
+  void push_back(const Pulse & p); //!< add a pulse, which must be later than any already in the history
+  void clear(); //!< drop all pulses
+  size_t size() const { return n; };
+
+  bool shares_any(const Pulse_History & h) const; //!< do this and h have any pulses in common?
+
+  //!< append to out the holders of all histories which have any pulses
+  // in common with this one, including this history's holder
+  void get_sharers(std::vector < Tag_Candidate * > & out) const;
+
+  void copy_to(Pulse_Buffer & buf) const; //!< replace contents of buf with the pulses, oldest first
+
+  template < class Archive >
+  void serialize(Archive & ar, const unsigned int version) {
+    ar & BOOST_SERIALIZATION_NVP( newest );
+    ar & BOOST_SERIALIZATION_NVP( n );
+    if (Archive::is_loading::value && newest)
+      add_holder();
+  };
+
+  static void end_load(); //!< rebuild rings of links for the same pulse, after loading all histories sharing links
+
+protected:
+
+  Link * newest; //!< link for the most recent pulse; 0 if history is empty
+  size_t n;      //!< number of pulses
+
+  Pulse_History * next_holder; //!< next history whose newest link is the same
+  Pulse_History * prev_holder; //!< previous history whose newest link is the same
+
+  static Link * last_link; //!< link most recently added to any history; 0 if freed
+  static unsigned last_stamp; //!< stamp of most recent search
+
+  static std::unordered_map < Pulse::Seq_No, Link * > loaded_links; //!< one loaded link for each pulse, until end_load()
+
+  void add_holder();    //!< add this history to its newest link's holders
+  void remove_holder(); //!< remove this history from its newest link's holders
+
+  static void release(Link * l); //!< drop a reference to l, freeing any links no longer referenced
+  static void add_child(Link * l); //!< add l to its prev's children
+  static void join_same(Link * l, Link * same); //!< add l to the ring containing same
+};
+
+#endif // PULSE_HISTORY_HPP
@@ -0,0 +1,196 @@
+#include "Record_Cache.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+constexpr char Record_Cache::MAGIC[9];
+
+std::string
+Record_Cache::path_for(std::string dir, std::string db_path, int monoBN) {
+  size_t slash = db_path.rfind('/');
+  std::ostringstream p;
+  p << dir << "/" << (slash == std::string::npos ? db_path : db_path.substr(slash + 1)) << "-" << monoBN << ".records";
+  return p.str();
+};
+
+Record_Cache::Record_Cache(std::string path, int monoBN, const std::vector < long long > & file_set) :
+  path(path),
+  tmp_path(path + ".tmp"),
+  f(0),
+  num_blocks(0),
+  num_records(0)
+{
+  f = fopen(tmp_path.c_str(), "wb");
+  if (! f) {
+    std::cerr << "Warning: unable to create record cache " << tmp_path << "; not caching records" << std::endl;
+    return;
+  }
+  Header h;
+  memset(& h, 0, sizeof(h));
+  memcpy(h.magic, MAGIC, sizeof(h.magic));
+  h.version = VERSION;
+  h.monoBN = monoBN;
+  h.num_files = file_set.size() / 3;
+  h.trailer = 0;
+  write(& h, sizeof(h));
+  write(file_set);
+};
+
+Record_Cache::~Record_Cache() {
+  if (f) {
+    fclose(f);
+    unlink(tmp_path.c_str());
+  }
+};
+
+void
+Record_Cache::fail(const char * what) {
+  if (! f)
+    return;
+  std::cerr << "Warning: unable to " << what << " record cache " << tmp_path << "; not caching records" << std::endl;
+  fclose(f);
+  f = 0;
+  unlink(tmp_path.c_str());
+};
+
+void
+Record_Cache::write(const void * p, size_t n) {
+  static const char zeroes[8] = {0};
+  if (! f)
+    return;
+  if ((n > 0 && fwrite(p, 1, n, f) != n)
+      || (padded(n) > n && fwrite(zeroes, 1, padded(n) - n, f) != padded(n) - n))
+    fail("write to");
+};
+
+void
+Record_Cache::put(const SG_Record & r) {
+  if (! f)
+    return;
+  type.push_back(r.type);
+  port.push_back(r.port);
+  ts.push_back(r.ts);
+  switch (r.type) {
+  case SG_Record::PULSE:
+    dfreq.push_back(r.v.dfreq);
+    sig.push_back(r.v.sig);
+    noise.push_back(r.v.noise);
+    break;
+  case SG_Record::GPS:
+    lat.push_back(r.v.lat);
+    lon.push_back(r.v.lon);
+    alt.push_back(r.v.alt);
+    break;
+  case SG_Record::PARAM:
+    param_value.push_back(r.v.param_value);
+    return_code.push_back(r.v.return_code);
+    strings.append(r.v.param_flag, strlen(r.v.param_flag) + 1);
+    strings.append(r.v.error, strlen(r.v.error) + 1);
+    break;
+  case SG_Record::CLOCK:
+    clock_level.push_back(r.v.clock_level);
+    clock_remaining.push_back(r.v.clock_remaining);
+    break;
+  default:
+    break;
+  }
+  if (type.size() == BLOCK_RECORDS)
+    write_block();
+};
+
+void
+Record_Cache::write_block() {
+  if (type.size() == 0)
+    return;
+  Block_Header b;
+  memset(& b, 0, sizeof(b));
+  b.n = type.size();
+  b.num_pulse = dfreq.size();
+  b.num_gps = lat.size();
+  b.num_param = param_value.size();
+  b.num_clock = clock_level.size();
+  b.str_bytes = strings.size();
+  b.bytes = padded(sizeof(b))
+    + padded(b.n * sizeof(uint8_t)) + padded(b.n * sizeof(Port_Num)) + padded(b.n * sizeof(Timestamp))
+    + 2 * padded(b.num_pulse * sizeof(SignaldB)) + padded(b.num_pulse * sizeof(Frequency_Offset_kHz))
+    + 3 * padded(b.num_gps * sizeof(double))
+    + padded(b.num_param * sizeof(double)) + padded(b.num_param * sizeof(int32_t))
+    + padded(b.num_clock * sizeof(int32_t)) + padded(b.num_clock * sizeof(double))
+    + padded(b.str_bytes);
+
+  write(& b, sizeof(b));
+  write(type);
+  write(port);
+  write(ts);
+  write(dfreq);
+  write(sig);
+  write(noise);
+  write(lat);
+  write(lon);
+  write(alt);
+  write(param_value);
+  write(return_code);
+  write(clock_level);
+  write(clock_remaining);
+  write(strings.data(), strings.size());
+
+  ++num_blocks;
+  num_records += type.size();
+
+  type.clear();
+  port.clear();
+  ts.clear();
+  dfreq.clear();
+  sig.clear();
+  noise.clear();
+  lat.clear();
+  lon.clear();
+  alt.clear();
+  param_value.clear();
+  return_code.clear();
+  clock_level.clear();
+  clock_remaining.clear();
+  strings.clear();
+};
+
+void
+Record_Cache::finish(const std::string & state, Timestamp fix_low, Timestamp fix_high, Timestamp fix_by, Timestamp fix_error) {
+  write_block();
+  if (! f)
+    return;
+
+  Trailer t;
+  memset(& t, 0, sizeof(t));
+  t.num_blocks = num_blocks;
+  t.num_records = num_records;
+  t.fix_low = fix_low;
+  t.fix_high = fix_high;
+  t.fix_by = fix_by;
+  t.fix_error = fix_error;
+  t.state_bytes = state.size();
+
+  long pos = ftell(f);
+  write(& t, sizeof(t));
+  write(state.data(), state.size());
+
+  // now that the file is complete, record where the trailer is
+  uint64_t trailer = pos;
+  if (! f || fseek(f, offsetof(Header, trailer), SEEK_SET) || fwrite(& trailer, sizeof(trailer), 1, f) != 1) {
+    fail("finish");
+    return;
+  }
+  if (fclose(f)) {
+    f = 0;
+    unlink(tmp_path.c_str());
+    std::cerr << "Warning: unable to finish record cache " << tmp_path << "; not caching records" << std::endl;
+    return;
+  }
+  f = 0;
+  if (rename(tmp_path.c_str(), path.c_str())) {
+    unlink(tmp_path.c_str());
+    std::cerr << "Warning: unable to rename record cache " << tmp_path << " to " << path << std::endl;
+  }
+};
@@ -0,0 +1,121 @@
+#ifndef RECORD_CACHE_HPP
+#define RECORD_CACHE_HPP
+
+#include "find_tags_common.hpp"
+#include "SG_Record.hpp"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+  Record_Cache - write the clock-corrected records for a boot session
+  to a cache file, so that later runs on the same input can read them
+  back with Record_Cache_Data_Source, instead of decompressing and
+  parsing raw files and repairing the clock again.
+
+  The cache is keyed by the boot session (monoBN) and the fileID, size
+  and isDone flag of each of its files, so it is ignored once files
+  have been added to the boot session or changed.
+
+  File layout (native byte order; the cache is not meant to be moved
+  between machines):
+
+    Header
+    file set: 3 x num_files int64: fileID, size, isDone for each file
+    blocks of up to BLOCK_RECORDS records, each a Block_Header followed
+      by columns: type, port, ts for all records; then dfreq, sig, noise
+      for pulses; lat, lon, alt for GPS fixes; value, return code for
+      parameter settings; level, remaining for clock settings; then the
+      flag and error strings of parameter settings, 0-terminated.
+      Each column is padded to a multiple of 8 bytes.
+    Trailer
+    serialized state of the data source at the end of the run
+
+  The file is written under a temporary name, and only renamed to its
+  real name by finish(), so an interrupted run never leaves a partial
+  cache.
+*/
+
+class Record_Cache {
+
+public:
+
+  static constexpr char MAGIC[9] = "FTRCACHE"; //!< first 8 bytes of a cache file
+  static const uint32_t VERSION = 3; //!< changes whenever the file layout or Tag_Foray::SERIALIZATION_VERSION does
+  static const uint32_t BLOCK_RECORDS = 65536; //!< maximum records per block
+
+  struct Header {
+    char magic[8];      //!< MAGIC, without the terminating 0
+    uint32_t version;   //!< VERSION
+    int32_t monoBN;     //!< boot session
+    uint64_t num_files; //!< number of files in file set
+    uint64_t trailer;   //!< offset of Trailer from start of file; 0 until finished
+  };
+
+  struct Block_Header {
+    uint64_t bytes;     //!< size of block, including this header
+    uint32_t n;         //!< number of records
+    uint32_t num_pulse; //!< number of PULSE records
+    uint32_t num_gps;   //!< number of GPS records
+    uint32_t num_param; //!< number of PARAM records
+    uint32_t num_clock; //!< number of CLOCK records
+    uint32_t str_bytes; //!< bytes of parameter setting strings
+  };
+
+  struct Trailer {
+    uint64_t num_blocks;  //!< number of blocks
+    uint64_t num_records; //!< total records in all blocks
+    Timestamp fix_low;    //!< time fix filed by Clock_Repair: low endpoint of timestamps corrected
+    Timestamp fix_high;   //!< high endpoint of timestamps corrected
+    Timestamp fix_by;     //!< amount added to timestamps
+    Timestamp fix_error;  //!< bound on error of corrected timestamps
+    uint64_t state_bytes; //!< bytes of serialized data source state following the trailer
+  };
+
+  static size_t padded(size_t n) { return (n + 7) & ~ (size_t) 7; }; //!< n rounded up to a multiple of 8
+
+  static std::string path_for(std::string dir, std::string db_path, int monoBN); //!< path of cache file in dir for a boot session of the receiver DB at db_path
+
+  Record_Cache(std::string path, int monoBN, const std::vector < long long > & file_set); //!< start writing the cache for boot session monoBN, whose files are given by DB_Filer::get_file_set()
+
+  ~Record_Cache(); //!< remove the temporary file if finish() was not called
+
+  void put(const SG_Record & r); //!< append a corrected record
+
+  void finish(const std::string & state, Timestamp fix_low, Timestamp fix_high, Timestamp fix_by, Timestamp fix_error); //!< write the remaining records, the time fix and the data source state, and move the file into place
+
+protected:
+
+  std::string path; //!< final path of cache file
+  std::string tmp_path; //!< path to which cache file is written
+  FILE * f; //!< open cache file; 0 if writing has failed or finished
+  uint64_t num_blocks; //!< number of blocks written
+  uint64_t num_records; //!< number of records written
+
+  // columns of the current block
+  std::vector < uint8_t > type;
+  std::vector < Port_Num > port;
+  std::vector < Timestamp > ts;
+  std::vector < Frequency_Offset_kHz > dfreq;
+  std::vector < SignaldB > sig;
+  std::vector < SignaldB > noise;
+  std::vector < double > lat;
+  std::vector < double > lon;
+  std::vector < double > alt;
+  std::vector < double > param_value;
+  std::vector < int32_t > return_code;
+  std::vector < int32_t > clock_level;
+  std::vector < double > clock_remaining;
+  std::string strings;
+
+  void write(const void * p, size_t n); //!< write n bytes, then pad to a multiple of 8 bytes
+  template < typename T > void write(const std::vector < T > & col) { write(col.data(), col.size() * sizeof(T)); };
+  void write_block(); //!< write and clear the current block, if not empty
+  void fail(const char * what); //!< warn, and give up writing the cache
+
+  // copying would share the open file
+  Record_Cache(const Record_Cache &) = delete;
+  Record_Cache & operator= (const Record_Cache &) = delete;
+};
+
+#endif // RECORD_CACHE_HPP
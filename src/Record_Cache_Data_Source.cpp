@@ -0,0 +1,167 @@
+#include "Record_Cache_Data_Source.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Record_Cache_Data_Source::Record_Cache_Data_Source(std::string path, int monoBN, const std::vector < long long > & file_set) :
+  base(0),
+  mapLen(0),
+  trailer(0),
+  next_block(0),
+  blocks_end(0),
+  n(0),
+  i(0)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (! fstat(fd, & st) && st.st_size >= (off_t) sizeof(Record_Cache::Header)) {
+    void * m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED) {
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+      base = reinterpret_cast < const char * > (m);
+      mapLen = st.st_size;
+    }
+  }
+  close(fd);
+  if (base && ! check(monoBN, file_set)) {
+    munmap(const_cast < char * > (base), mapLen);
+    base = 0;
+    mapLen = 0;
+  }
+};
+
+Record_Cache_Data_Source::~Record_Cache_Data_Source() {
+  if (base)
+    munmap(const_cast < char * > (base), mapLen);
+};
+
+bool
+Record_Cache_Data_Source::check(int monoBN, const std::vector < long long > & file_set) {
+  auto h = reinterpret_cast < const Record_Cache::Header * > (base);
+  if (memcmp(h->magic, Record_Cache::MAGIC, sizeof(h->magic))
+      || h->version != Record_Cache::VERSION
+      || h->monoBN != monoBN
+      || h->num_files != file_set.size() / 3
+      || h->trailer == 0
+      || h->trailer + sizeof(Record_Cache::Trailer) > mapLen)
+    return false;
+
+  // the set of files must not have changed since the cache was written
+  const char * p = base + sizeof(Record_Cache::Header);
+  size_t fs_bytes = file_set.size() * sizeof(long long);
+  if (memcmp(p, file_set.data(), fs_bytes))
+    return false;
+
+  trailer = reinterpret_cast < const Record_Cache::Trailer * > (base + h->trailer);
+  if (h->trailer + sizeof(Record_Cache::Trailer) + trailer->state_bytes > mapLen)
+    return false;
+
+  next_block = p + Record_Cache::padded(fs_bytes);
+  blocks_end = base + h->trailer;
+
+  // walk the block headers, to be sure they fit
+  uint64_t nb = 0, nr = 0;
+  for (const char * b = next_block; b < blocks_end; ++nb) {
+    auto bh = reinterpret_cast < const Record_Cache::Block_Header * > (b);
+    if (bh->bytes < sizeof(*bh) || bh->bytes > (size_t) (blocks_end - b))
+      return false;
+    nr += bh->n;
+    b += bh->bytes;
+  }
+  return nb == trailer->num_blocks && nr == trailer->num_records;
+};
+
+void
+Record_Cache_Data_Source::file_batch_info(DB_Filer * db, int monoBN) {
+  db->add_time_fix(trailer->fix_low, trailer->fix_high, trailer->fix_by, trailer->fix_error, 'S');
+  db->add_batch_files(monoBN);
+};
+
+bool
+Record_Cache_Data_Source::start_block() {
+  if (next_block >= blocks_end)
+    return false;
+  auto bh = reinterpret_cast < const Record_Cache::Block_Header * > (next_block);
+  const char * p = next_block + Record_Cache::padded(sizeof(*bh));
+  next_block += bh->bytes;
+
+  // lay out the columns in the order Record_Cache::write_block() wrote them
+  auto column = [&p] (size_t bytes) {
+    const char * c = p;
+    p += Record_Cache::padded(bytes);
+    return c;
+  };
+  n = bh->n;
+  type            = reinterpret_cast < const uint8_t * >              (column(n * sizeof(uint8_t)));
+  port            = reinterpret_cast < const Port_Num * >             (column(n * sizeof(Port_Num)));
+  ts              = reinterpret_cast < const Timestamp * >            (column(n * sizeof(Timestamp)));
+  dfreq           = reinterpret_cast < const Frequency_Offset_kHz * > (column(bh->num_pulse * sizeof(Frequency_Offset_kHz)));
+  sig             = reinterpret_cast < const SignaldB * >             (column(bh->num_pulse * sizeof(SignaldB)));
+  noise           = reinterpret_cast < const SignaldB * >             (column(bh->num_pulse * sizeof(SignaldB)));
+  lat             = reinterpret_cast < const double * >               (column(bh->num_gps * sizeof(double)));
+  lon             = reinterpret_cast < const double * >               (column(bh->num_gps * sizeof(double)));
+  alt             = reinterpret_cast < const double * >               (column(bh->num_gps * sizeof(double)));
+  param_value     = reinterpret_cast < const double * >               (column(bh->num_param * sizeof(double)));
+  return_code     = reinterpret_cast < const int32_t * >              (column(bh->num_param * sizeof(int32_t)));
+  clock_level     = reinterpret_cast < const int32_t * >              (column(bh->num_clock * sizeof(int32_t)));
+  clock_remaining = reinterpret_cast < const double * >               (column(bh->num_clock * sizeof(double)));
+  strings         = column(bh->str_bytes);
+
+  i = i_pulse = i_gps = i_param = i_clock = 0;
+  return true;
+};
+
+bool
+Record_Cache_Data_Source::get_record(SG_Record & r) {
+  if (i == n && ! start_block())
+    return false;
+
+  r.type = (SG_Record::Type) type[i];
+  r.port = port[i];
+  r.ts = ts[i];
+  switch (r.type) {
+  case SG_Record::PULSE:
+    r.v.dfreq = dfreq[i_pulse];
+    r.v.sig = sig[i_pulse];
+    r.v.noise = noise[i_pulse];
+    ++i_pulse;
+    break;
+  case SG_Record::GPS:
+    r.v.lat = lat[i_gps];
+    r.v.lon = lon[i_gps];
+    r.v.alt = alt[i_gps];
+    ++i_gps;
+    break;
+  case SG_Record::PARAM:
+    r.v.param_value = param_value[i_param];
+    r.v.return_code = return_code[i_param];
+    ++i_param;
+    strcpy(r.v.param_flag, strings);
+    strings += strlen(strings) + 1;
+    strcpy(r.v.error, strings);
+    strings += strlen(strings) + 1;
+    break;
+  case SG_Record::CLOCK:
+    r.v.clock_level = clock_level[i_clock];
+    r.v.clock_remaining = clock_remaining[i_clock];
+    ++i_clock;
+    break;
+  default:
+    break;
+  }
+  ++i;
+  return true;
+};
+
+// The state is saved in the format of the data source that wrote the
+// cache, so that a later run can --resume from it using that source.
+
+void
+Record_Cache_Data_Source::serialize(boost::archive::binary_oarchive & ar, const unsigned int version) {
+  ar.save_binary(reinterpret_cast < const char * > (trailer + 1), trailer->state_bytes);
+};
@@ -0,0 +1,57 @@
+#ifndef RECORD_CACHE_DATA_SOURCE_HPP
+#define RECORD_CACHE_DATA_SOURCE_HPP
+
+//!< Source for clock-corrected SG records from a cache file written by
+//!< Record_Cache on an earlier run over the same boot session.
+
+#include "find_tags_common.hpp"
+#include "Data_Source.hpp"
+#include "DB_Filer.hpp"
+#include "Record_Cache.hpp"
+
+class Record_Cache_Data_Source : public Data_Source {
+
+public:
+  Record_Cache_Data_Source(std::string path, int monoBN, const std::vector < long long > & file_set); //!< map the cache file at path; see valid()
+  ~Record_Cache_Data_Source();
+
+  bool valid() { return base != 0; }; //!< true if the file is a complete cache for boot session monoBN with the given file set
+
+  void file_batch_info(DB_Filer * db, int monoBN); //!< record the time fix and the files used, as a run on the raw files would have
+
+  bool get_record(SG_Record & r); //!< get the next cached record
+  bool has_corrected_timestamps() { return true; };
+
+  using Data_Source::serialize;
+  void serialize(boost::archive::binary_oarchive & ar, const unsigned int version); //!< write the state saved by the run which wrote the cache
+
+protected:
+  const char * base; //!< start of mapped file; 0 if not valid
+  size_t mapLen; //!< length of mapped file
+  const Record_Cache::Trailer * trailer; //!< trailer in mapped file
+  const char * next_block; //!< next block to read
+  const char * blocks_end; //!< end of blocks
+
+  // columns of the current block, and index of the next record in each
+  uint32_t n, i;
+  uint32_t i_pulse, i_gps, i_param, i_clock;
+  const uint8_t * type;
+  const Port_Num * port;
+  const Timestamp * ts;
+  const Frequency_Offset_kHz * dfreq;
+  const SignaldB * sig;
+  const SignaldB * noise;
+  const double * lat;
+  const double * lon;
+  const double * alt;
+  const double * param_value;
+  const int32_t * return_code;
+  const int32_t * clock_level;
+  const double * clock_remaining;
+  const char * strings;
+
+  bool check(int monoBN, const std::vector < long long > & file_set); //!< is the mapped file a valid and complete cache for this input?
+  bool start_block(); //!< set up columns of the next block; false if none remain
+};
+
+#endif // RECORD_CACHE_DATA_SOURCE_HPP
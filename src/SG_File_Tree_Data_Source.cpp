@@ -0,0 +1,321 @@
+#include "SG_File_Tree_Data_Source.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static bool
+ends_with(const std::string & s, const char * suffix) {
+  size_t n = strlen(suffix);
+  return s.length() >= n && ! s.compare(s.length() - n, n, suffix);
+};
+
+SG_File_Tree_Data_Source::SG_File_Tree_Data_Source(std::string source) :
+  files(),
+  cur(-1),
+  pending(true),
+  skip(0),
+  text(0),
+  next(0),
+  end(0),
+  base(0),
+  mapLen(0),
+  gz(0),
+  gzbuf(),
+  originFile(0),
+  originOffset(0),
+  fileTSLine()
+{
+  if (source.length() > 0 && source[0] == '@') {
+    std::ifstream list(source.substr(1));
+    if (! list)
+      throw std::runtime_error(std::string("Unable to open file list ") + source.substr(1));
+    std::string path;
+    while (std::getline(list, path)) {
+      while (path.length() > 0 && isspace(path[path.length() - 1]))
+        path.resize(path.length() - 1);
+      if (path.length() > 0)
+        add_path(path, true);
+    }
+  } else {
+    add_path(source, true);
+  }
+  std::sort(files.begin(), files.end());
+
+  // drop X.txt where X.txt.gz is also present; the compressed file
+  // sorts first and is the one kept
+  files.erase(std::unique(files.begin(), files.end(),
+                          [](const Raw_File & a, const Raw_File & b) {
+                            return a.ts == b.ts && a.name == b.name;
+                          }),
+              files.end());
+};
+
+SG_File_Tree_Data_Source::~SG_File_Tree_Data_Source() {
+  close_file();
+};
+
+void
+SG_File_Tree_Data_Source::add_path(std::string path, bool explicitly_named) {
+  struct stat st;
+  if (stat(path.c_str(), & st)) {
+    if (explicitly_named)
+      throw std::runtime_error(std::string("Unable to find file or directory ") + path);
+    return;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    DIR * dir = opendir(path.c_str());
+    if (! dir)
+      throw std::runtime_error(std::string("Unable to read directory ") + path);
+    while (struct dirent * de = readdir(dir)) {
+      if (! strcmp(de->d_name, ".") || ! strcmp(de->d_name, ".."))
+        continue;
+      add_path(path + "/" + de->d_name, false);
+    }
+    closedir(dir);
+    return;
+  }
+  // files found in a directory must look like raw SG files
+  if (! explicitly_named && ! (ends_with(path, ".txt") || ends_with(path, ".txt.gz")))
+    return;
+
+  Raw_File f;
+  f.path = path;
+  size_t slash = path.rfind('/');
+  f.name = slash == std::string::npos ? path : path.substr(slash + 1);
+  f.gz = ends_with(f.name, ".gz");
+  if (f.gz)
+    f.name.resize(f.name.length() - 3);
+  f.ts = filename_ts(f.name);
+  files.push_back(f);
+};
+
+Timestamp
+SG_File_Tree_Data_Source::filename_ts(const std::string & name) {
+  // look for a timestamp like 2017-09-01T16-08-51.2850, as in the SG file name
+  // changeMe-1614BBBK1911-000125-2017-09-01T16-08-51.2850P-all.txt.gz
+  // In the pattern, 'd' matches any digit.
+  static const char pattern[] = "dddd-dd-ddTdd-dd-dd";
+  static const size_t plen = sizeof(pattern) - 1;
+
+  for (size_t i = 0; i + plen <= name.length(); ++i) {
+    size_t j;
+    for (j = 0; j < plen; ++j) {
+      char c = name[i + j];
+      if (pattern[j] == 'd' ? ! isdigit(c) : c != pattern[j])
+        break;
+    }
+    if (j < plen)
+      continue;
+    const char * s = name.c_str() + i;
+    struct tm t;
+    memset(& t, 0, sizeof(t));
+    t.tm_year = atoi(s) - 1900;
+    t.tm_mon  = atoi(s + 5) - 1;
+    t.tm_mday = atoi(s + 8);
+    t.tm_hour = atoi(s + 11);
+    t.tm_min  = atoi(s + 14);
+    t.tm_sec  = atoi(s + 17);
+    Timestamp ts = timegm(& t);
+    if (s[plen] == '.' && isdigit(s[plen + 1]))
+      ts += strtod(s + plen, 0);
+    return ts;
+  }
+  return 0;
+};
+
+bool
+SG_File_Tree_Data_Source::open_file(int i) {
+  if (i >= (int) files.size())
+    return false;
+  close_file();
+  cur = i;
+  const Raw_File & f = files[i];
+  if (f.gz) {
+    gz = gzopen(f.path.c_str(), "rb");
+    if (! gz) {
+      std::cerr << "Warning: unable to open file " << f.path << "; skipping it" << std::endl;
+    } else {
+      gzbuffer(gz, GZ_READ_BUF_SIZE);
+      if (gzbuf.size() < (size_t) GZ_BUF_SIZE)
+        gzbuf.resize(GZ_BUF_SIZE);
+      text = next = end = & gzbuf[0];
+      if (skip > 0) {
+        if (gzseek(gz, skip, SEEK_SET) < 0) {
+          gzclose(gz);
+          gz = 0;
+        } else {
+          base = skip;
+        }
+      }
+    }
+  } else {
+    int fd = open(f.path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, & st)) {
+      std::cerr << "Warning: unable to open file " << f.path << "; skipping it" << std::endl;
+    } else if (st.st_size > 0) {
+      void * m = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m == MAP_FAILED)
+        throw std::runtime_error(std::string("Unable to map file ") + f.path);
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+      mapLen = st.st_size;
+      text = reinterpret_cast < const char * > (m);
+      next = text + std::min((long long) mapLen, skip);
+      end = text + mapLen;
+    }
+    if (fd >= 0)
+      close(fd);
+  }
+  skip = 0;
+  pending = false;
+  return true;
+};
+
+void
+SG_File_Tree_Data_Source::close_file() {
+  if (mapLen > 0)
+    munmap(const_cast < char * > (text), mapLen);
+  mapLen = 0;
+  if (gz)
+    gzclose(gz);
+  gz = 0;
+  text = next = end = 0;
+  base = 0;
+};
+
+bool
+SG_File_Tree_Data_Source::fill() {
+  if (! gz)
+    return false;
+
+  // move any unread text to the start of the buffer, first growing
+  // the buffer if that text fills more than half of it
+
+  size_t from = next - text;
+  size_t keep = end - next;
+  if (keep > gzbuf.size() / 2)
+    gzbuf.resize(2 * gzbuf.size());
+  memmove(& gzbuf[0], & gzbuf[from], keep);
+  base += from;
+  text = next = & gzbuf[0];
+  end = text + keep;
+
+  int n = gzread(gz, & gzbuf[keep], gzbuf.size() - keep);
+  if (n > 0) {
+    end += n;
+    return true;
+  }
+  if (n < 0) {
+    int err;
+    std::cerr << "Warning: error decompressing file " << files[cur].path << ": " << gzerror(gz, & err) << "; skipping the rest of it" << std::endl;
+  }
+  gzclose(gz);
+  gz = 0;
+  return false;
+};
+
+bool
+SG_File_Tree_Data_Source::getline(char * buf, int maxLen) {
+  const char * line;
+  int len;
+  if (! getline_view(line, len))
+    return false;
+
+  // truncate to max permitted line size; we silently discard the remainder
+  len = std::min(len, maxLen);
+
+  memcpy(buf, line, len);
+  buf[len] = '\0';
+  return true;
+};
+
+bool
+SG_File_Tree_Data_Source::getline_view(const char * & line, int & len) {
+  for (;;) {
+    if (next == end && ! fill()) {
+      // current file is exhausted (or there isn't one yet), so move to the next
+      bool at_start = skip == 0;
+      if (! open_file(cur + 1))
+        return false;
+      if (at_start && files[cur].ts > 0) {
+        // generate a synthetic "File Timestamp" line like this:
+        // F,1432456345.2345
+        std::ostringstream ft_rec;
+        ft_rec << "F," << std::setprecision(14) << files[cur].ts;
+        fileTSLine = ft_rec.str();
+        line = fileTSLine.c_str();
+        len = fileTSLine.length();
+        return true;
+      }
+      continue;
+    }
+    const char * eol = reinterpret_cast < const char * > (memchr(next, '\n', end - next));
+    if (! eol && fill())
+      continue; // line might continue past the text we have; look again
+
+    // if no eol found, line goes to end of file
+    int lineLen = eol ? eol - next : end - next;
+    line = next;
+    len = lineLen;
+    next += eol ? lineLen + 1 : lineLen;
+    return true;
+  }
+};
+
+void
+SG_File_Tree_Data_Source::rewind() {
+  close_file();
+  cur = originFile - 1;
+  skip = originOffset;
+  pending = true;
+};
+
+// The position saved is the file's timestamp and name, and the offset in
+// its text of the next line to read; files may have been added, or
+// compressed, by the time we resume.
+
+void
+SG_File_Tree_Data_Source::serialize(boost::archive::binary_iarchive & ar, const unsigned int version) {
+  Raw_File f;
+  long long offset;
+  ar & make_nvp("fileTS", f.ts);
+  ar & make_nvp("fileName", f.name);
+  ar & BOOST_SERIALIZATION_NVP( offset );
+
+  // resume at the saved file, if still present, or else at the first later one
+  f.gz = true;
+  originFile = std::lower_bound(files.begin(), files.end(), f) - files.begin();
+  if (originFile < (int) files.size() && files[originFile].ts == f.ts && files[originFile].name == f.name)
+    originOffset = offset;
+  else
+    originOffset = 0;
+  rewind();
+};
+
+void
+SG_File_Tree_Data_Source::serialize(boost::archive::binary_oarchive & ar, const unsigned int version) {
+  int i = pending ? cur + 1 : cur;
+  long long offset = pending ? skip : pos();
+  Raw_File f;
+  f.ts = 0;
+  if (i < (int) files.size()) {
+    f = files[i];
+  } else if (files.size() > 0) {
+    // rewound to past the last file; save the end of that
+    f = files.back();
+    offset = std::numeric_limits < long long > :: max();
+  }
+  ar & make_nvp("fileTS", f.ts);
+  ar & make_nvp("fileName", f.name);
+  ar & BOOST_SERIALIZATION_NVP( offset );
+};
@@ -0,0 +1,78 @@
+#ifndef SG_FILE_TREE_DATA_SOURCE_HPP
+#define SG_FILE_TREE_DATA_SOURCE_HPP
+
+//!< Source for SG-format input data read directly from raw receiver
+//!< files: a single file, a directory tree of them, or a list of files
+//!< and directories.  Plain files are memory-mapped; files ending in
+//!< `.gz` are decompressed as they are read.  Files are read in order of
+//!< the timestamp embedded in their names, and each is preceded by a
+//!< synthetic "F,TIMESTAMP" record, as with SG_SQLite_Data_Source.
+
+#include <zlib.h>
+#include "find_tags_common.hpp"
+#include "Data_Source.hpp"
+
+class SG_File_Tree_Data_Source : public Data_Source {
+
+public:
+  //!< source is the path to a file or directory, or "@" followed by the
+  // path to a text file listing files and directories, one per line.
+  // Directories are searched recursively for files whose names end in
+  // `.txt` or `.txt.gz`; if both X.txt and X.txt.gz are found, only the
+  // latter is used.
+  SG_File_Tree_Data_Source(std::string source);
+  ~SG_File_Tree_Data_Source();
+  bool getline(char * buf, int maxLen);
+  bool getline_view(const char * & line, int & len); //!< view of next line, pointing into the mapped file or decompression buffer
+  void rewind();
+
+  static Timestamp filename_ts(const std::string & name); //!< timestamp embedded in a raw SG file name, or 0 if there is none
+
+protected:
+
+  //!< a raw input file
+  struct Raw_File {
+    Timestamp ts;      //!< timestamp from file name; 0 if none
+    std::string name;  //!< file name without directory or any trailing `.gz`; with ts, orders and identifies files
+    std::string path;  //!< path to open
+    bool gz;           //!< is file gzip-compressed?
+
+    bool operator< (const Raw_File & f) const {
+      return ts < f.ts || (ts == f.ts && (name < f.name || (name == f.name && gz > f.gz)));
+    };
+  };
+
+  static const int GZ_BUF_SIZE = 1 << 22; //!< initial size of buffer for decompressed text; it grows if a line doesn't fit
+  static const int GZ_READ_BUF_SIZE = 1 << 20; //!< size of zlib's buffer for compressed input
+
+  std::vector < Raw_File > files; //!< input files, in the order they are read
+  int cur; //!< index in files of current file; -1 before the first
+  bool pending; //!< true after rewind(), until file cur + 1 is opened
+  long long skip; //!< bytes of text to skip when opening the next file; used by rewind()
+
+  const char * text; //!< start of current file's text in memory: the mapping, or gzbuf
+  const char * next; //!< next unread character of text
+  const char * end; //!< end of text in memory
+  long long base; //!< offset in the current file of `text`; non-zero only for compressed files
+  size_t mapLen; //!< length of mapping of current file; 0 if not mapped
+
+  gzFile gz; //!< current compressed file; 0 if none
+  std::vector < char > gzbuf; //!< buffer for decompressed text
+
+  int originFile; //!< index of file to which we rewind
+  long long originOffset; //!< offset in that file to which we rewind
+
+  std::string fileTSLine; //!< synthetic "F,TIMESTAMP" line for the current file
+
+  void add_path(std::string path, bool explicitly_named); //!< add file at path, or files under it if it is a directory
+  bool open_file(int i); //!< make files[i] the current file, skipping `skip` bytes of text; false if there is no such file
+  void close_file(); //!< release the current file, if any
+  bool fill(); //!< read more text from the current compressed file; false if there is none
+  long long pos() { return base + (next - text); }; //!< offset in current file of next unread character
+
+  void serialize(boost::archive::binary_iarchive & ar, const unsigned int version);
+  void serialize(boost::archive::binary_oarchive & ar, const unsigned int version);
+
+};
+
+#endif // SG_FILE_TREE_DATA_SOURCE
@@ -1,15 +1,259 @@
 #include "SG_Record.hpp"
 
 #include <string.h>
+#include <stdint.h>
+#include <cfloat>
 #include <sstream>
+#include <algorithm>
 
 SG_Record::SG_Record() :
   v()
 {
 };
 
+/*
+  Hand-written field parsers for from_buf.
+
+  These handle only the plain forms of numbers which SG receivers
+  write (optional sign, decimal digits, optional decimal point and
+  fraction).  Each returns a pointer just past the field, or 0 if the
+  field is not in that form, in which case the caller falls back to
+  from_buf_sscanf, so that results are always identical to those of
+  the sscanf parser.
+
+  Decimal values are only converted here when the mantissa and power
+  of ten are both exactly representable in the target type, so that
+  a single division gives the correctly-rounded value, exactly as
+  strtod / strtof would (Clinger's fast path).  Anything else
+  (exponents, hex, nan, inf, too many digits) is left to sscanf.
+*/
+
+#if FLT_EVAL_METHOD == 0
+#define SG_FAST_FLOAT_PARSE
+#endif
+
+namespace {
+
+  const double pow10_d[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const float pow10_f[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+  };
+
+  inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+  };
+
+  // scan a plain decimal number into an integer mantissa and the
+  // number of digits after the decimal point
+
+  const char * scan_decimal(const char * p, const char * end, bool & neg, uint64_t & mant, int & frac) {
+    neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      neg = *p == '-';
+      ++p;
+    }
+    mant = 0;
+    frac = 0;
+    int digits = 0;
+    while (p < end && is_digit(*p)) {
+      mant = mant * 10 + (*p++ - '0');
+      ++digits;
+    }
+    if (p < end && *p == '.') {
+      ++p;
+      while (p < end && is_digit(*p)) {
+        mant = mant * 10 + (*p++ - '0');
+        ++digits;
+        ++frac;
+      }
+    }
+    // no digits, or too many for the mantissa to be exact
+    if (digits == 0 || digits > 19)
+      return 0;
+    // exponent, hex prefix, or similar: not handled here
+    if (p < end && (*p == 'e' || *p == 'E' || *p == 'x' || *p == 'X' || *p == 'p' || *p == 'P'))
+      return 0;
+    return p;
+  };
+
+  const char * parse_double(const char * p, const char * end, double & x) {
+#ifdef SG_FAST_FLOAT_PARSE
+    bool neg;
+    uint64_t mant;
+    int frac;
+    p = scan_decimal(p, end, neg, mant, frac);
+    if (! p || mant > (1ULL << 53) || frac > 22)
+      return 0;
+    double d = (double) mant;
+    if (frac)
+      d /= pow10_d[frac];
+    x = neg ? -d : d;
+    return p;
+#else
+    return 0;
+#endif
+  };
+
+  const char * parse_float(const char * p, const char * end, float & x) {
+#ifdef SG_FAST_FLOAT_PARSE
+    bool neg;
+    uint64_t mant;
+    int frac;
+    p = scan_decimal(p, end, neg, mant, frac);
+    if (! p || mant > (1ULL << 24) || frac > 10)
+      return 0;
+    float f = (float) mant;
+    if (frac)
+      f /= pow10_f[frac];
+    x = neg ? -f : f;
+    return p;
+#else
+    return 0;
+#endif
+  };
+
+  // parse an integer of at most max_digits digits, so that it can't
+  // overflow the target type; sscanf's behaviour on overflow is left to
+  // sscanf
+
+  template < typename T >
+  const char * parse_int(const char * p, const char * end, T & x, int max_digits) {
+    bool neg = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      neg = *p == '-';
+      ++p;
+    }
+    const char * start = p;
+    int i = 0;
+    while (p < end && is_digit(*p)) {
+      i = i * 10 + (*p++ - '0');
+      if (p - start > max_digits)
+        return 0;
+    }
+    if (p == start)
+      return 0;
+    x = neg ? -i : i;
+    return p;
+  };
+
+  inline const char * expect(const char * p, const char * end, char c) {
+    return (p && p < end && *p == c) ? p + 1 : 0;
+  };
+
+  inline bool has_text(const char * p, const char * end, const char * text, int n) {
+    return end - p >= n && ! memcmp(p, text, n);
+  };
+}
+
 void
 SG_Record::from_buf(char * buf) {
+  from_buf(buf, strlen(buf));
+};
+
+void
+SG_Record::from_buf(const char * buf, int len) {
+  const char * end = buf + len;
+  const char * p = 0;
+
+  switch (len > 0 ? buf[0] : '\0') {
+  case 'p':
+    p = expect(parse_int(buf + 1, end, port, 4), end, ',');
+    p = p ? expect(parse_double(p, end, ts), end, ',') : 0;
+    p = p ? expect(parse_float(p, end, v.dfreq), end, ',') : 0;
+    p = p ? expect(parse_float(p, end, v.sig), end, ',') : 0;
+    p = p ? parse_float(p, end, v.noise) : 0;
+    if (p) {
+      type = PULSE;
+      return;
+    }
+    break;
+
+  case 'G':
+    if (len < 2)
+      break;
+    p = expect(parse_double(buf + 2, end, ts), end, ',');
+    p = p ? expect(parse_double(p, end, v.lat), end, ',') : 0;
+    p = p ? expect(parse_double(p, end, v.lon), end, ',') : 0;
+    p = p ? parse_double(p, end, v.alt) : 0;
+    if (p) {
+      type = GPS;
+      return;
+    }
+    break;
+
+  case 'S':
+    if (len < 2)
+      break;
+    p = expect(parse_double(buf + 2, end, ts), end, ',');
+    p = p ? expect(parse_int(p, end, port, 4), end, ',') : 0;
+    if (p && ! has_text(p, end, "-w,", 3)) {
+      const char * f = p;
+      while (p < end && *p != ',' && *p != '\0')
+        ++p;
+      int n = p - f;
+      if (n > 0 && n < (int) sizeof(v.param_flag)) {
+        p = expect(p, end, ',');
+        const char * q = p ? parse_double(p, end, v.param_value) : 0;
+        if (! q && p) {
+          if (has_text(p, end, "undefined,", 10))
+            q = p + 9;
+          else if (has_text(p, end, "null,", 5))
+            q = p + 4;
+          if (q)
+            v.param_value = nan("0");
+        }
+        q = q ? expect(q, end, ',') : 0;
+        if (q && parse_int(q, end, v.return_code, 9)) {
+          memcpy(v.param_flag, f, n);
+          v.param_flag[n] = '\0';
+          v.error[0] = '\0';
+          type = PARAM;
+          return;
+        }
+      }
+    }
+    break;
+
+  case 'C':
+    if (len < 2)
+      break;
+    p = expect(parse_double(buf + 2, end, ts), end, ',');
+    p = p ? expect(parse_int(p, end, v.clock_level, 9), end, ',') : 0;
+    p = p ? parse_double(p, end, v.clock_remaining) : 0;
+    if (p) {
+      type = CLOCK;
+      return;
+    }
+    break;
+
+  case 'F':
+    if (len < 2)
+      break;
+    if (parse_double(buf + 2, end, ts)) {
+      type = SG_Record::FILE;
+      return;
+    }
+    break;
+
+  default:
+    type = BAD;
+    return;
+  }
+  // not a form handled above; sscanf will sort it out, but needs a
+  // 0-terminated copy
+  char tmp[MAX_LINE_SIZE + 1];
+  len = std::min(len, (int) MAX_LINE_SIZE);
+  memcpy(tmp, buf, len);
+  tmp[len] = '\0';
+  from_buf_sscanf(tmp);
+};
+
+void
+SG_Record::from_buf_sscanf(char * buf) {
   // assume invalid record
   type = BAD;
   switch (buf[0]) {
@@ -47,7 +47,11 @@ struct SG_Record {
 
   SG_Record();
 
-  void from_buf(char * buf);        //!< construct from buffer
+  void from_buf(char * buf);        //!< construct from 0-terminated buffer
+
+  void from_buf(const char * buf, int len); //!< construct from a line of len characters, which need not be 0-terminated
+
+  void from_buf_sscanf(char * buf); //!< construct from buffer using sscanf; reference parser, and fallback for lines from_buf doesn't handle
 
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version)
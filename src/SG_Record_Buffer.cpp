@@ -0,0 +1,178 @@
+#include "SG_Record_Buffer.hpp"
+
+#include <string.h>
+
+// encoding helpers: copy a field to or from the byte stream
+
+template < typename T >
+static inline void
+put_field(std::vector < char > & buf, const T & x) {
+  const char * p = reinterpret_cast < const char * > (& x);
+  buf.insert(buf.end(), p, p + sizeof(T));
+};
+
+template < typename T >
+static inline void
+get_field(const char * & p, T & x) {
+  memcpy(& x, p, sizeof(T));
+  p += sizeof(T);
+};
+
+static inline void
+put_string(std::vector < char > & buf, const char * s) {
+  buf.insert(buf.end(), s, s + strlen(s) + 1);
+};
+
+static inline void
+get_string(const char * & p, char * s) {
+  size_t n = strlen(p) + 1;
+  memcpy(s, p, n);
+  p += n;
+};
+
+SG_Record_Buffer::SG_Record_Buffer(size_t max_mem) :
+  max_mem(max_mem),
+  buf(),
+  spill(0),
+  chunks(),
+  count(0),
+  replaying(false),
+  chunk(),
+  next_chunk(0),
+  rd(0),
+  rd_end(0)
+{
+};
+
+SG_Record_Buffer::~SG_Record_Buffer() {
+  clear();
+};
+
+void
+SG_Record_Buffer::put(const SG_Record & r) {
+  if (r.type == SG_Record::BAD)
+    return;
+  if (replaying)
+    throw std::runtime_error("SG_Record_Buffer: put() called after start_replay()");
+
+  buf.push_back((char) r.type);
+  put_field(buf, r.ts);
+  put_field(buf, r.port);
+  switch (r.type) {
+  case SG_Record::PULSE:
+    put_field(buf, r.v.dfreq);
+    put_field(buf, r.v.sig);
+    put_field(buf, r.v.noise);
+    break;
+  case SG_Record::GPS:
+    put_field(buf, r.v.lat);
+    put_field(buf, r.v.lon);
+    put_field(buf, r.v.alt);
+    break;
+  case SG_Record::PARAM:
+    put_field(buf, r.v.param_value);
+    put_field(buf, r.v.return_code);
+    put_string(buf, r.v.param_flag);
+    put_string(buf, r.v.error);
+    break;
+  case SG_Record::CLOCK:
+    put_field(buf, r.v.clock_level);
+    put_field(buf, r.v.clock_remaining);
+    break;
+  default:
+    break;
+  }
+  ++count;
+
+  if (buf.size() >= max_mem) {
+    // move the records in memory to the temporary file
+    if (! spill) {
+      spill = tmpfile();
+      if (! spill)
+        throw std::runtime_error("SG_Record_Buffer: unable to create temporary file");
+    }
+    if (fwrite(& buf[0], 1, buf.size(), spill) != buf.size())
+      throw std::runtime_error("SG_Record_Buffer: unable to write to temporary file");
+    chunks.push_back(buf.size());
+    buf.clear();
+  }
+};
+
+void
+SG_Record_Buffer::start_replay() {
+  replaying = true;
+  next_chunk = 0;
+  if (spill)
+    rewind(spill);
+  rd = rd_end = 0;
+};
+
+bool
+SG_Record_Buffer::get(SG_Record & r) {
+  if (! replaying)
+    return false;
+  if (rd == rd_end) {
+    // read back the next block from the temporary file, or else
+    // continue with the records in memory
+    if (next_chunk < chunks.size()) {
+      chunk.resize(chunks[next_chunk]);
+      if (fread(& chunk[0], 1, chunk.size(), spill) != chunk.size())
+        throw std::runtime_error("SG_Record_Buffer: unable to read from temporary file");
+      rd = & chunk[0];
+      rd_end = rd + chunk.size();
+      ++next_chunk;
+    } else if (next_chunk == chunks.size() && buf.size() > 0) {
+      rd = & buf[0];
+      rd_end = rd + buf.size();
+      ++next_chunk;
+    } else {
+      clear();
+      return false;
+    }
+  }
+
+  const char * p = rd;
+  r.type = (SG_Record::Type) * p++;
+  get_field(p, r.ts);
+  get_field(p, r.port);
+  switch (r.type) {
+  case SG_Record::PULSE:
+    get_field(p, r.v.dfreq);
+    get_field(p, r.v.sig);
+    get_field(p, r.v.noise);
+    break;
+  case SG_Record::GPS:
+    get_field(p, r.v.lat);
+    get_field(p, r.v.lon);
+    get_field(p, r.v.alt);
+    break;
+  case SG_Record::PARAM:
+    get_field(p, r.v.param_value);
+    get_field(p, r.v.return_code);
+    get_string(p, r.v.param_flag);
+    get_string(p, r.v.error);
+    break;
+  case SG_Record::CLOCK:
+    get_field(p, r.v.clock_level);
+    get_field(p, r.v.clock_remaining);
+    break;
+  default:
+    break;
+  }
+  rd = p;
+  return true;
+};
+
+void
+SG_Record_Buffer::clear() {
+  if (spill)
+    fclose(spill);
+  spill = 0;
+  std::vector < char > ().swap(buf);
+  std::vector < char > ().swap(chunk);
+  chunks.clear();
+  count = 0;
+  replaying = false;
+  next_chunk = 0;
+  rd = rd_end = 0;
+};
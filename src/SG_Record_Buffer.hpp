@@ -0,0 +1,57 @@
+#ifndef SG_RECORD_BUFFER_HPP
+#define SG_RECORD_BUFFER_HPP
+
+#include "find_tags_common.hpp"
+#include "SG_Record.hpp"
+
+#include <stdio.h>
+
+/*
+  SG_Record_Buffer - an append-only buffer of SG_Records, which can
+  then be replayed once, in order.
+
+  Records are stored in a compact variable-length encoding: only the
+  fields used by each record type are kept, so a pulse takes 23 bytes
+  rather than sizeof(SG_Record).  When the encoded records exceed
+  max_mem bytes, they are written to an anonymous temporary file, so
+  that memory use stays bounded however many records are buffered.
+*/
+
+class SG_Record_Buffer {
+
+public:
+
+  static const size_t DEFAULT_MAX_MEM = 64 * 1024 * 1024; //!< default maximum bytes of encoded records kept in memory
+
+  SG_Record_Buffer(size_t max_mem = DEFAULT_MAX_MEM);
+  ~SG_Record_Buffer();
+
+  void put(const SG_Record & r); //!< append a record; BAD records are not stored
+
+  void start_replay(); //!< stop appending; subsequent calls to get() return the records in the order they were put
+
+  bool get(SG_Record & r); //!< get the next buffered record and return true; return false, and empty the buffer, once all have been returned
+
+  void clear(); //!< discard all records, free memory, and remove any temporary file
+
+  unsigned long long size() { return count; }; //!< number of records in buffer
+
+protected:
+  size_t max_mem;                  //!< maximum bytes of encoded records kept in memory
+  std::vector < char > buf;        //!< encoded records not yet written to the temporary file
+  FILE * spill;                    //!< temporary file holding earlier encoded records; 0 if none
+  std::vector < size_t > chunks;   //!< sizes of the blocks of records written to the temporary file
+  unsigned long long count;        //!< number of records put
+
+  bool replaying;                  //!< true after start_replay()
+  std::vector < char > chunk;      //!< block of encoded records read back from the temporary file
+  size_t next_chunk;               //!< index in chunks of next block to read back
+  const char * rd;                 //!< next encoded record to return
+  const char * rd_end;             //!< end of encoded records in memory at rd
+
+  // copying would share the temporary file
+  SG_Record_Buffer(const SG_Record_Buffer &) = delete;
+  SG_Record_Buffer & operator= (const SG_Record_Buffer &) = delete;
+};
+
+#endif // SG_RECORD_BUFFER_HPP
@@ -15,6 +15,22 @@ SG_SQLite_Data_Source::SG_SQLite_Data_Source(DB_Filer * db, unsigned int monoBN)
 
 bool
 SG_SQLite_Data_Source::getline(char * buf, int maxLen) {
+  const char * line;
+  int len;
+  if (! getline_view(line, len))
+    return false;
+
+  // truncate to max permitted line size; we silently discard the remainder
+  len = std::min(len, maxLen);
+
+  // copy to output
+  memcpy(buf, line, len); // NB: we know these regions don't overlap; else we'd use memmove
+  buf[len] = '\0';        // terminating 0
+  return true;
+};
+
+bool
+SG_SQLite_Data_Source::getline_view(const char * & line, int & len) {
 
   // bytesLeft will be -1 if we read an unterminated line on previous call
 
@@ -35,7 +51,9 @@ SG_SQLite_Data_Source::getline(char * buf, int maxLen) {
     // F,1432456345.2345
     std::ostringstream ft_rec;
     ft_rec << "F," << std::setprecision(14) << blobTS;
-    strcpy(buf, ft_rec.str().c_str());
+    fileTSLine = ft_rec.str();
+    line = fileTSLine.c_str();
+    len = fileTSLine.length();
     return true;
   }
   const char * start = blob + offset;
@@ -44,12 +62,8 @@ SG_SQLite_Data_Source::getline(char * buf, int maxLen) {
   // if no eol found, line goes to end of blob
   int lineLen = eol ? eol - start : bytesLeft;
 
-  // truncate to max permitted line size; we silently discard the remainder
-  int useLineLen = std::min(lineLen, maxLen);
-
-  // copy to output
-  memcpy(buf, start, useLineLen); // NB: we know these regions don't overlap; else we'd use memmove
-  buf[useLineLen] = '\0';        // terminating 0
+  line = start;
+  len = lineLen;
   bytesLeft -= lineLen + 1;      // NB: include the '\n' char in the calculation; will get -1 for unterminated line
   offset += lineLen + 1;
   return true;
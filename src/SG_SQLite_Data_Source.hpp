@@ -14,6 +14,7 @@ public:
   SG_SQLite_Data_Source(DB_Filer * db, unsigned int monoBN);
   ~SG_SQLite_Data_Source();
   bool getline(char * buf, int maxLen);
+  bool getline_view(const char * & line, int & len); //!< view of next line, pointing directly into the blob
   void rewind();
 
 protected:
@@ -26,6 +27,7 @@ protected:
   int originOffset; //!< offset from first blob to which we rewind, after resume()
   int originBytesLeft; //!< bytes left in blob after rewind, after resume()
   char emptyBlob[1]; //!< empty buffer for initial blob
+  std::string fileTSLine; //!< synthetic "F,TIMESTAMP" line for the current blob
 
   void serialize(boost::archive::binary_iarchive & ar, const unsigned int version);
   void serialize(boost::archive::binary_oarchive & ar, const unsigned int version);
@@ -1,4 +1,12 @@
 #include "Set.hpp"
+
+#include <algorithm>
+
+static bool
+tag_less (const TagPhase & a, const TagPhase & b) {
+  return std::less < TagID > () (a.first, b.first);
+};
+
 Set *
 Set::empty() {
   return _empty;
@@ -22,7 +30,7 @@ Set::numSets() {
   return _numSets;
 };
 
-Set::Set() : s(), _label(maxLabel++) , hash(0) {
+Set::Set() : s(), _label(maxLabel++) , hash(0), refs(0) {
 #ifdef DEBUG2
   std::cerr << "Set::Set() " << (void* ) this << std::endl;
   allSets.insert(this);
@@ -30,28 +38,53 @@ Set::Set() : s(), _label(maxLabel++) , hash(0) {
   ++_numSets;
 };
 
-Set::Set(TagPhase p) : s(), _label(maxLabel++), hash(hashT(p.first)) {
-    s.insert(p);
-#ifdef DEBUG2
-    std::cerr << "Set::Set(TagPhase) " << (void* ) this << std::endl;
-    allSets.insert(this);
-#endif
-    ++_numSets;
+Set *
+Set::intern(const TagPhaseSet & s, TagPhaseSetHash hash) {
+  if (s.size() == 0)
+    return _empty;
+  auto r = interned.equal_range(hash);
+  for (auto i = r.first; i != r.second; ++i)
+    if (i->second->s == s)
+      return i->second;
+  Set * ns = new Set();
+  ns->s = s;
+  ns->hash = hash;
+  interned.insert(std::make_pair(hash, ns));
+  return ns;
+};
+
+Set *
+Set::make(const TagPhaseSet & s) {
+  scratch = s;
+  std::sort(scratch.begin(), scratch.end(), tag_less);
+  TagPhaseSetHash hash = 0;
+  for (auto & p : scratch)
+    hash ^= hashT(p);
+  return intern(scratch, hash);
+};
+
+TagPhaseSet::const_iterator
+Set::find(TagID id) const {
+  auto i = std::lower_bound(s.begin(), s.end(), TagPhase(id, 0), tag_less);
+  if (i != s.end() && i->first == id)
+    return i;
+  return s.end();
 };
 
 Set *
 Set::augment(TagPhase p) {
-  // augment this set with p, unless this set is empty
-  // in which case return a new set with just p;
-  if(this == _empty)
-    return new Set(p);
-  for(auto e = s.equal_range(p.first); e.first != e.second; ++e.first) {
-    if (e.first->second == p.second)
+  // a set has at most one phase per tag, so adding another phase
+  // for a tag already present leaves the set unchanged
+  auto i = std::lower_bound(s.begin(), s.end(), p, tag_less);
+  if (i != s.end() && i->first == p.first) {
+    if (i->second == p.second)
       throw std::runtime_error("Adding existing tagphase to tagphaseset");
+    return this;
   }
-  s.insert(p);
-  hash ^= hashT(p.first);
-  return this;
+  scratch.assign(s.begin(), i);
+  scratch.push_back(p);
+  scratch.insert(scratch.end(), i, s.end());
+  return intern(scratch, hash ^ hashT(p));
 };
 
 Set *
@@ -60,69 +93,71 @@ Set::reduce(Tag * t) {
   // reduction leads to that
   if(this == _empty)
     throw std::runtime_error("Reducing empty set");
-  erase(t);
-  hash ^= hashT(t);
-  if (s.size() == 0) {
-    delete this;
-    return _empty;
+  auto i = find(t);
+  if (i == s.end())
+    return this;
+  scratch.assign(s.cbegin(), i);
+  scratch.insert(scratch.end(), i + 1, s.cend());
+  return intern(scratch, hash ^ hashT(*i));
+};
+
+Set *
+Set::rename(Tag * t1, Tag * t2) {
+  // Ambiguity can hand back the same proxy, when it absorbs a tag
+  auto i = find(t1);
+  if (i == s.end() || t1 == t2)
+    return this;
+  if (find(t2) != s.end())
+    return reduce(t1);
+  TagPhase p(t2, i->second);
+  scratch.clear();
+  for (auto j = s.begin(); j != s.end(); ++j)
+    if (j != i)
+      scratch.push_back(*j);
+  scratch.insert(std::lower_bound(scratch.begin(), scratch.end(), p, tag_less), p);
+  return intern(scratch, hash ^ hashT(*i) ^ hashT(p));
+};
+
+void
+Set::acquire() {
+  ++refs;
+};
+
+void
+Set::release() {
+  if (this == _empty || --refs > 0)
+    return;
+  auto r = interned.equal_range(hash);
+  for (auto i = r.first; i != r.second; ++i) {
+    if (i->second == this) {
+      interned.erase(i);
+      break;
+    }
   }
-  return this;
+  delete this;
 };
 
 void
-Set::erase(Tag * t) {
-    // erase specific element t from multimap; i.e. match
-    // by both key and value
-  s.erase(t);
+Set::index() {
+  std::sort(s.begin(), s.end(), tag_less);
+  hash = 0;
+  for (auto & p : s)
+    hash ^= hashT(p);
+  if (s.size() > 0)
+    interned.insert(std::make_pair(hash, this));
 };
 
 int
 Set::count(TagID id) const {
-  return s.count(id);
+  return find(id) != s.end();
 };
 
 int
 Set::count(TagPhase p) const {
   // count specific element p from map; i.e. match
   // by both key and value; returns 0 or 1
-  auto r = s.equal_range(p.first);
-  for (auto i = r.first; i != r.second; ++i)
-    if (i->second == p.second)
-      return 1;
-  return 0;
-};
-
-Set *
-Set::cloneAugment(TagPhase p) {
-  // return pointer to clone of this Set, augmented by p
-  if (this == _empty)
-    return new Set(p);
-  for(auto e = s.equal_range(p.first); e.first != e.second; ++e.first) {
-    if (e.first->second == p.second)
-      throw std::runtime_error("Adding existing tagphase to tagphaseset");
-  }
-  Set * ns = new Set();
-  ns->s = s;
-  ns->s.insert(p);
-  ns->hash = hash ^ hashT(p.first);
-  return ns;
-};
-
-
-Set *
-Set::cloneReduce(Tag * t) {
-  // return pointer to clone of this Set, reduced by p
-  if (count(t) == 0)
-    throw std::runtime_error("Set::cloneReduce(t) called with t not in set");
-  Set * ns = new Set();
-  ns->s = s;
-  ns->erase(t);
-  if (ns->s.size() == 0) {
-    delete ns;
-    return empty();
-  }
-  ns->hash = hash ^ hashT(t);
-  return ns;
+  auto i = find(p.first);
+  return i != s.end() && i->second == p.second;
 };
 
 #ifdef DEBUG2
@@ -167,12 +202,17 @@ Set::unique() const {
 
 bool
 Set::operator== (const Set & s) const {
-  return hash == s.hash && this->s == s.s;
+  return this == & s || (hash == s.hash && this->s == s.s);
 };
 
 TagPhaseSetHash
-Set::hashT (Tag * t) {
-  return reinterpret_cast < long long > (t);
+Set::hashT (TagPhase p) {
+  // the splitmix64 finalizer, so that XORs of hashes of nearby tag
+  // addresses spread over all bits
+  unsigned long long x = reinterpret_cast < unsigned long long > (p.first) ^ ((unsigned long long) (unsigned short) p.second << 48);
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
 };
 
 Set * Set::_empty = 0;
@@ -181,3 +221,5 @@ std::set < Set * > Set::allSets = std::set < Set * > ();
 #endif
 int Set::_numSets = 0;
 int Set::maxLabel = 0;
+Set::Intern_Table Set::interned;
+TagPhaseSet Set::scratch;
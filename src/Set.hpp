@@ -4,11 +4,33 @@
 #include "find_tags_common.hpp"
 #include "Tag.hpp"
 
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/split_member.hpp>
+
 class Graph;
 class Node;
 
 typedef size_t TagPhaseSetHash;
 
+/*
+  Set - a set of tag phases, as labels a Node of the DFA graph.
+
+  Sets are immutable and interned: there is at most one Set with any
+  given contents, shared by all nodes (of any graph) having those
+  contents, so that sets can be compared by pointer.  Adding or
+  removing a tag phase finds or creates the interned result, rather
+  than copying the set and then looking up its copy.
+
+  The tag phases are kept in a vector sorted by tag.  The hash of a
+  set is the XOR of a well-mixed hash of each tag phase, so it can be
+  updated as a tag phase is added or removed.
+
+  Each Node holding a set holds a reference to it, and a set is
+  deleted when the last reference is released.  The empty set is
+  never deleted, and is not in the intern table.
+*/
+
 class Set {
   friend class Node;
   friend class Graph;
@@ -20,6 +42,7 @@ protected:
   TagPhaseSet s;
   int _label;
   TagPhaseSetHash hash;
+  int refs; //!< number of references held by Nodes
 
   static int _numSets;
   static int maxLabel;
@@ -28,6 +51,11 @@ protected:
   static std::set < Set * > allSets;
 #endif
 
+  typedef std::unordered_multimap < TagPhaseSetHash, Set * > Intern_Table;
+  static Intern_Table interned; //!< all non-empty sets, by hash
+
+  static TagPhaseSet scratch; //!< contents of a set being looked up
+
 public:
   static Set * empty();
   int label() const;
@@ -38,20 +66,22 @@ public:
 
   Set();
 
-  Set(TagPhase p);
+  static Set * make(const TagPhaseSet & s); //!< the set with tag phases s, in any order, with at most one per tag
+
+  Set * augment(TagPhase p); //!< the set with this set's tag phases and p
+
+  Set * reduce(Tag *t); //!< the set with this set's tag phases other than t's
+
+  Set * rename(Tag *t1, Tag *t2); //!< the set with this set's tag phases, but with t1's given to t2 instead
 
-  Set * augment(TagPhase p);
+  void acquire(); //!< add a reference to this set
 
-  Set * reduce(Tag *t);
-  void erase(Tag *t);
+  void release(); //!< drop a reference to this set, deleting it if that was the last
 
   int count(TagID id) const;
 
   int count(TagPhase p) const;
 
-  Set * cloneAugment(TagPhase p);
-  Set * cloneReduce(Tag * t);
-
 #ifdef DEBUG
   static void dumpAll();
 #endif
@@ -65,16 +95,32 @@ public:
   bool unique() const;
 
 private:
-  static TagPhaseSetHash hashT (Tag * t);
+  static TagPhaseSetHash hashT (TagPhase p);
+
+  static Set * intern(const TagPhaseSet & s, TagPhaseSetHash hash); //!< the set with contents s, which has hash hash
+
+  TagPhaseSet::const_iterator find(TagID id) const; //!< the tag phase for id, or s.end()
+
+  void index(); //!< sort loaded contents, recompute the hash, and add to the intern table
 
 public:
   template<class Archive>
-  void serialize(Archive & ar, const unsigned int version) {
+  void save(Archive & ar, const unsigned int version) const {
+    ar & BOOST_SERIALIZATION_NVP( s );
+    ar & BOOST_SERIALIZATION_NVP( _label );
+    ar & BOOST_SERIALIZATION_NVP( refs );
+  };
+
+  template<class Archive>
+  void load(Archive & ar, const unsigned int version) {
     ar & BOOST_SERIALIZATION_NVP( s );
     ar & BOOST_SERIALIZATION_NVP( _label );
-    ar & BOOST_SERIALIZATION_NVP( hash );
+    ar & BOOST_SERIALIZATION_NVP( refs );
+    // tags are at new addresses, so the order and hash have changed
+    index();
   };
 
+  BOOST_SERIALIZATION_SPLIT_MEMBER();
 };
 
 struct hashSet {
@@ -85,13 +131,10 @@ struct hashSet {
 };
 
 struct SetEqual {
-  // comparison function used in DFA::setToNode
+  // comparison function used in DFA::setToNode; sets are interned,
+  // so equal sets are the same object
   bool operator() ( const Set * x1, const Set * x2 ) const {
-    if (! x1 && ! x2)
-      return true;
-    if (!x1 || ! x2)
-      return false;
-    return x1->s == x2->s; // fixme slow direct comparison
+    return x1 == x2;
   };
 };
 
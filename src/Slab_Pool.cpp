@@ -0,0 +1,156 @@
+#include "Slab_Pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+
+// objects are aligned as strictly as anything malloc() returns
+static const size_t OBJ_ALIGN = alignof(std::max_align_t);
+
+static size_t
+round_up(size_t n, size_t to) {
+  return (n + to - 1) / to * to;
+};
+
+Slab_Pool::Slab_Pool(size_t obj_size) :
+  obj_size(round_up(std::max(obj_size, sizeof(void *)), OBJ_ALIGN)),
+  per_slab((SLAB_BYTES - round_up(sizeof(Slab), OBJ_ALIGN)) / this->obj_size),
+  partial(0),
+  full(0),
+  spare(0),
+  num_live(0),
+  num_slabs(0),
+  max_num_slabs(0)
+{
+  if (per_slab < 2)
+    throw std::runtime_error("Slab_Pool: objects too large for slab");
+};
+
+Slab_Pool::~Slab_Pool() {
+  while (partial) {
+    Slab * s = partial;
+    unlink(s, partial);
+    free_slab(s);
+  }
+  while (full) {
+    Slab * s = full;
+    unlink(s, full);
+    free_slab(s);
+  }
+  if (spare)
+    free_slab(spare);
+};
+
+Slab_Pool::Slab *
+Slab_Pool::new_slab() {
+  void * m;
+  if (posix_memalign(& m, SLAB_BYTES, SLAB_BYTES))
+    throw std::bad_alloc();
+  Slab * s = static_cast < Slab * > (m);
+  s->pool = this;
+  s->prev = s->next = 0;
+  s->free = 0;
+  s->unused = static_cast < char * > (m) + round_up(sizeof(Slab), OBJ_ALIGN);
+  s->live = 0;
+  if (++num_slabs > max_num_slabs)
+    max_num_slabs = num_slabs;
+  if (++total_slabs > max_total_slabs)
+    max_total_slabs = total_slabs;
+  return s;
+};
+
+void
+Slab_Pool::free_slab(Slab * s) {
+  free(s);
+  --num_slabs;
+  --total_slabs;
+};
+
+void
+Slab_Pool::unlink(Slab * s, Slab * & list) {
+  if (s->prev)
+    s->prev->next = s->next;
+  else
+    list = s->next;
+  if (s->next)
+    s->next->prev = s->prev;
+  s->prev = s->next = 0;
+};
+
+void
+Slab_Pool::link(Slab * s, Slab * & list) {
+  s->prev = 0;
+  s->next = list;
+  if (list)
+    list->prev = s;
+  list = s;
+};
+
+void *
+Slab_Pool::alloc() {
+  if (! partial) {
+    Slab * s = spare ? spare : new_slab();
+    spare = 0;
+    link(s, partial);
+  }
+  Slab * s = partial;
+  void * p;
+  if (s->free) {
+    p = s->free;
+    s->free = * static_cast < void ** > (p);
+  } else {
+    p = s->unused;
+    s->unused += obj_size;
+  }
+  ++num_live;
+  if (++s->live == per_slab) {
+    unlink(s, partial);
+    link(s, full);
+  }
+  return p;
+};
+
+void
+Slab_Pool::release(void * p) {
+  if (! p)
+    return;
+  Slab * s = reinterpret_cast < Slab * > (reinterpret_cast < uintptr_t > (p) & ~ (uintptr_t) (SLAB_BYTES - 1));
+  s->pool->give_back(p);
+};
+
+void
+Slab_Pool::give_back(void * p) {
+  Slab * s = reinterpret_cast < Slab * > (reinterpret_cast < uintptr_t > (p) & ~ (uintptr_t) (SLAB_BYTES - 1));
+  * static_cast < void ** > (p) = s->free;
+  s->free = p;
+  --num_live;
+  if (s->live-- == per_slab) {
+    unlink(s, full);
+    link(s, partial);
+  }
+  if (s->live == 0) {
+    // keep one empty slab, reset so its objects are handed out in order
+    unlink(s, partial);
+    if (spare) {
+      free_slab(s);
+    } else {
+      s->free = 0;
+      s->unused = reinterpret_cast < char * > (s) + round_up(sizeof(Slab), OBJ_ALIGN);
+      spare = s;
+    }
+  }
+};
+
+long long
+Slab_Pool::get_total_slabs() {
+  return total_slabs;
+};
+
+long long
+Slab_Pool::get_max_total_slabs() {
+  return max_total_slabs;
+};
+
+long long Slab_Pool::total_slabs = 0;
+long long Slab_Pool::max_total_slabs = 0;
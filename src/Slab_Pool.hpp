@@ -0,0 +1,80 @@
+#ifndef SLAB_POOL_HPP
+#define SLAB_POOL_HPP
+
+#include "find_tags_common.hpp"
+
+#include <stdint.h>
+
+/*
+  Slab_Pool - allocator for many small objects of the same size.
+
+  Objects are carved from slabs of SLAB_BYTES bytes, each aligned on a
+  multiple of its size, so that the slab (and so the pool) an object
+  belongs to can be found from the object's address alone.  Each slab
+  keeps its own list of free objects.  A slab whose objects have all
+  been released is returned to the system, except that each pool keeps
+  one empty slab in reserve, so that a population hovering around a
+  slab boundary doesn't repeatedly allocate and free a slab.
+
+  Destroying a pool frees all its slabs, whether or not the objects in
+  them have been released; their destructors are not called.
+
+  Not thread-safe.
+*/
+
+class Slab_Pool {
+
+public:
+
+  static const size_t SLAB_BYTES = 64 * 1024; //!< size and alignment of each slab
+
+  Slab_Pool(size_t obj_size); //!< pool for objects of obj_size bytes; must be small enough that a slab holds several
+  ~Slab_Pool();
+
+  void * alloc(); //!< get storage for one object
+
+  static void release(void * p); //!< return storage obtained from alloc() on any pool to that pool
+
+  long long get_num_live() { return num_live; }; //!< objects allocated and not released
+  long long get_num_slabs() { return num_slabs; }; //!< slabs held
+  long long get_max_num_slabs() { return max_num_slabs; }; //!< most slabs held at once
+
+  static long long get_total_slabs(); //!< slabs held by all pools
+  static long long get_max_total_slabs(); //!< most slabs held at once by all pools
+
+protected:
+
+  struct Slab {
+    Slab_Pool * pool; //!< pool this slab belongs to
+    Slab * prev;      //!< links in the pool's list of partly-used or full slabs
+    Slab * next;
+    void * free;      //!< list of released objects, linked through their first word
+    char * unused;    //!< start of objects never yet allocated
+    unsigned live;    //!< objects allocated from this slab and not released
+  };
+
+  size_t obj_size;       //!< bytes per object, rounded up for alignment
+  unsigned per_slab;     //!< objects per slab
+  Slab * partial;        //!< slabs with objects available
+  Slab * full;           //!< slabs with no objects available
+  Slab * spare;          //!< empty slab kept in reserve; 0 if none
+
+  long long num_live;
+  long long num_slabs;
+  long long max_num_slabs;
+
+  static long long total_slabs;
+  static long long max_total_slabs;
+
+  Slab * new_slab();
+  void free_slab(Slab * s);
+  void unlink(Slab * s, Slab * & list);
+  void link(Slab * s, Slab * & list);
+  void give_back(void * p); //!< return p, which belongs to one of this pool's slabs
+
+  // copying would share slabs
+  Slab_Pool(const Slab_Pool &) = delete;
+  Slab_Pool & operator= (const Slab_Pool &) = delete;
+};
+
+#endif // SLAB_POOL_HPP
@@ -2,6 +2,20 @@
 
 #include "Tag_Foray.hpp"
 
+#include <limits>
+
+Tag_Candidate::Tag_Candidate() :
+  expiry_slot(Expiry_Index::NOT_INDEXED),
+  tag_prev(0),
+  tag_next(0),
+  node_prev(0),
+  node_next(0),
+  sid(Graph_Table::NO_STATE),
+  sid_gen(0)
+{
+  pulses.holder = this;
+};
+
 Tag_Candidate::Tag_Candidate(Tag_Finder *owner, Node *state, const Pulse &pulse) :
   owner(owner),
   state(state),
@@ -14,10 +28,19 @@ Tag_Candidate::Tag_Candidate(Tag_Finder *owner, Node *state, const Pulse &pulse)
   hit_count(0),
   num_pulses(0),
   freq_range(freq_slop_kHz, pulse.dfreq),
-  sig_range(sig_slop_dB, pulse.sig)
+  sig_range(sig_slop_dB, pulse.sig),
+  expiry_slot(Expiry_Index::NOT_INDEXED),
+  tag_prev(0),
+  tag_next(0),
+  node_prev(0),
+  node_next(0),
+  sid(Graph_Table::NO_STATE),
+  sid_gen(0)
 {
+  pulses.holder = this;
   pulses.push_back(pulse);
   state->tcLink();
+  link_state();
   if (++num_cands > max_num_cands) {
     max_num_cands = num_cands;
     max_cand_time = pulse.ts;
@@ -25,6 +48,9 @@ Tag_Candidate::Tag_Candidate(Tag_Finder *owner, Node *state, const Pulse &pulse)
 };
 
 Tag_Candidate::~Tag_Candidate() {
+  owner->expiries.remove(this);
+  owner->unindex_tag(this);
+  unlink_state();
   maybe_end_run();
   --num_cands;
 };
@@ -44,10 +70,36 @@ Tag_Candidate::maybe_end_run() {
   run_id = 0;
 };
 
+void *
+Tag_Candidate::operator new(size_t size) {
+  static Slab_Pool shared_pool(sizeof(Tag_Candidate));
+  return shared_pool.alloc();
+};
+
+void *
+Tag_Candidate::operator new(size_t size, Tag_Finder * owner) {
+  return owner->cand_pool.alloc();
+};
+
+void
+Tag_Candidate::operator delete(void * p) {
+  Slab_Pool::release(p);
+};
+
+void
+Tag_Candidate::operator delete(void * p, Tag_Finder * owner) {
+  Slab_Pool::release(p);
+};
+
 Tag_Candidate *
 Tag_Candidate::clone() {
-  auto tc = new Tag_Candidate(* this);
+  auto tc = new (owner) Tag_Candidate(* this);
+  tc->expiry_slot = Expiry_Index::NOT_INDEXED;
+  tc->pulses.holder = tc;
+  tc->tag_prev = tc->tag_next = 0;
+  owner->index_tag(tc);
   tc->state->tcLink();
+  tc->link_state();
   if (++num_cands > max_num_cands) {
     max_num_cands = num_cands;
     max_cand_time = last_ts;
@@ -65,24 +117,7 @@ bool Tag_Candidate::shares_any_pulses(Tag_Candidate *tc) {
   // does this tag candidate use any of the pulses
   // used by another candidate?
 
-  // these are two vectors, sorted in order of pulse seq_no,
-  // so compare them that way.
-
-  auto i1 = pulses.begin();
-  auto e1 = pulses.end();
-  auto i2 = tc->pulses.begin();
-  auto e2 = tc->pulses.end();
-
-  while(i1 != e1 && i2 != e2) {
-    if (i1->seq_no < i2->seq_no) {
-      ++ i1;
-    } else if (i1->seq_no > i2->seq_no) {
-      ++ i2;
-    } else {
-      return true;
-    }
-  }
-  return false;
+  return pulses.shares_any(tc->pulses);
 };
 
 bool
@@ -93,9 +128,14 @@ Tag_Candidate::expired(Timestamp ts) {
 #endif
     return true;
   }
+  if (auto fs = frozen_state())
+    // nodes in the table are part of the graph, so still valid
+    return ts - last_ts > fs->max_age;
+
   bool rv = ts - last_ts > state->get_max_age();
 
   if (! state->valid()) {
+    unlink_state();
     if (state->tcUnlink())
       state = 0;
     return true;
@@ -105,9 +145,47 @@ Tag_Candidate::expired(Timestamp ts) {
 
 Timestamp
 Tag_Candidate::min_next_pulse_ts() {
-  return last_ts + state->get_min_age();
+  auto fs = frozen_state();
+  return last_ts + (fs ? fs->min_age : state->get_min_age());
+};
+
+Gap
+Tag_Candidate::get_max_age() {
+  auto fs = frozen_state();
+  return fs ? fs->max_age : state->get_max_age();
 };
 
+void
+Tag_Candidate::link_state() {
+  node_prev = 0;
+  node_next = state->cands;
+  if (node_next)
+    node_next->node_prev = this;
+  state->cands = this;
+};
+
+void
+Tag_Candidate::unlink_state() {
+  if (node_prev)
+    node_prev->node_next = node_next;
+  else if (state && state->cands == this)
+    state->cands = node_next;
+  else
+    return; // not linked
+  if (node_next)
+    node_next->node_prev = node_prev;
+  node_prev = node_next = 0;
+};
+
+const Graph_Table::State *
+Tag_Candidate::frozen_state() {
+  Graph_Table & t = owner->graph->get_table();
+  if (sid_gen != t.get_gen()) {
+    sid = t.id_of(state);
+    sid_gen = t.get_gen();
+  }
+  return sid != Graph_Table::NO_STATE ? & t.state(sid) : 0;
+};
 
 Node *
 Tag_Candidate::advance_by_pulse(const Pulse &p) {
@@ -118,8 +196,26 @@ Tag_Candidate::advance_by_pulse(const Pulse &p) {
 
   Gap gap = p.ts - last_ts;
 
-  // try walk the DFA with this gap
-  return state->advance(gap);
+  // try walk the DFA with this gap; a state which has left the graph
+  // can still be walked, via its node
+
+  if (! frozen_state())
+    return state->advance(gap);
+
+  Graph_Table & t = owner->graph->get_table();
+  auto s = t.advance(sid, gap);
+  return s != Graph_Table::NO_STATE ? t.state(s).node : 0;
+};
+
+void
+Tag_Candidate::profile(Tag_Candidate * tc, Cand_List::Profile & pr) {
+  pr.last_ts = tc->last_ts;
+  // a candidate at a node which has left the graph is expired, but
+  // only expired() can deal with it, so make sure that gets called
+  auto fs = tc->frozen_state();
+  pr.max_age = fs ? fs->max_age : - std::numeric_limits < Gap > :: infinity();
+  tc->freq_range.get_compatible_limits(pr.f_low, pr.f_high, pr.f_width);
+  tc->sig_range.get_compatible_limits(pr.s_low, pr.s_high, pr.s_width);
 };
 
 bool
@@ -147,18 +243,22 @@ Tag_Candidate::add_pulse(const Pulse &p, Node *new_state) {
   pulses.push_back(p);
   last_ts = p.ts;
 
-  // adjust use counts for states
+  // adjust use counts and candidate lists for states
+  unlink_state();
   new_state->tcLink();
   state->tcUnlink();
 
   state = new_state;
+  link_state();
+  sid_gen = 0;
+  auto fs = frozen_state();
 
   // see whether the tag_id_level can increase
 
   if (tag_id_level == MULTIPLE) {
-    if (state->is_unique()) {
+    if (fs ? fs->unique : state->is_unique()) {
       // we now know which tag this must be, if it is one
-      tag = state->get_tag();
+      set_tag(fs ? fs->tag : state->get_tag());
       num_pulses = tag->gaps.size();
       tag_id_level = SINGLE;
     }
@@ -174,7 +274,8 @@ Tag_Candidate::add_pulse(const Pulse &p, Node *new_state) {
     // pulses there are per burst, so we can tell whether this pulse completes
     // a burst
 
-    pulse_completes_burst = new_state->get_phase() % num_pulses == num_pulses - 1;
+    Phase phase = (fs && fs->unique) ? fs->phase : state->get_phase();
+    pulse_completes_burst = phase % num_pulses == num_pulses - 1;
 
     // At the CONFIRMED level, if this pulse completes a burst, then
     // this candidate is deemed to own the pulses in its buffer.
@@ -218,6 +319,13 @@ Tag_Candidate::get_tag() {
   return tag;
 };
 
+void
+Tag_Candidate::set_tag(Tag * t) {
+  owner->unindex_tag(this);
+  tag = t;
+  owner->index_tag(this);
+};
+
 Tag_Candidate::Tag_ID_Level Tag_Candidate::get_tag_id_level() {
   return tag_id_level;
 };
@@ -242,7 +350,7 @@ void Tag_Candidate::clear_pulses() {
 };
 
 void
-Tag_Candidate::calculate_burst_params(Pulse_Iter & p) {
+Tag_Candidate::calculate_burst_params(Pulse_Iter & p, Burst_Params & bp) {
   // calculate these burst parameters:
   // - mean signal and noise strengths
   // - relative standard deviation (among pulses) of signal strength
@@ -250,48 +358,48 @@ Tag_Candidate::calculate_burst_params(Pulse_Iter & p) {
   // - total slop in gap sizes between observed pulses and registered tag values
 
   // side effect: set last_dumped_ts
-  // return true if successful, false otherwise
 
-  float sig		= 0.0;
+  unsigned int n = num_pulses;
+  const Pulse * b = & *p;
+
+  if (last_dumped_ts != BOGUS_TIMESTAMP) {
+    Gap g = b[0].ts - last_dumped_ts;
+    bp.burst_slop = fmodf(g, tag->period) - tag->gaps[n-1];
+  } else {
+    bp.burst_slop = BOGUS_BURST_SLOP;
+  }
+
+  // each sum is accumulated in pulse order and in float, as it always
+  // has been, so that reported values don't change in the last bit
+
   float sigsum	= 0.0;
   float sigsumsq	= 0.0;
   float noise		= 0.0;
   float freqsum	= 0.0;
   float freqsumsq	= 0.0;
   float slop   	= 0.0;
-  double pts		= 0.0;
 
-  unsigned int n = num_pulses;
-
-  if (last_dumped_ts != BOGUS_TIMESTAMP) {
-    Gap g = p->ts - last_dumped_ts;
-    burst_par.burst_slop = fmodf(g, tag->period) - tag->gaps[n-1];
-  } else {
-    burst_par.burst_slop = BOGUS_BURST_SLOP;
+  for (unsigned int i = 0; i < n; ++i) {
+    sigsum	  += b[i].sig_lin;
+    sigsumsq	  += b[i].sig_lin * b[i].sig_lin;
+    noise	  += b[i].noise_lin;
+    freqsum	  += b[i].dfreq;
+    freqsumsq	  += b[i].dfreq * b[i].dfreq;
   }
+  for (unsigned int i = 1; i < n; ++i)
+    slop += fabsf( (b[i].ts - b[i-1].ts) - tag->gaps[i-1]);
 
-  for (unsigned int i = 0; i < n; ++i, ++p) {
-    sig	   = powf(10.0, p->sig / 10.0);
-    sigsum	  += sig;
-    sigsumsq	  += sig*sig;
-    noise	  += powf(10.0, p->noise / 10.0);
-    freqsum	  += p->dfreq;
-    freqsumsq	  += p->dfreq * p->dfreq;
-    if (i > 0) {
-      slop += fabsf( (p->ts - pts) - tag->gaps[i-1]);
-    }
-    pts = p->ts;
-  }
-  last_dumped_ts     = pts;
-  burst_par.sig      = 10.0 *	log10f(sigsum / n);
-  burst_par.noise    = 10.0 *	log10f(noise / n);
+  p += n;
+  last_dumped_ts = b[n-1].ts;
+  bp.sig      = 10.0 *	log10f(sigsum / n);
+  bp.noise    = 10.0 *	log10f(noise / n);
   double sig_radicand = n * sigsumsq - sigsum * sigsum;
-  burst_par.sig_sd   = sig_radicand >= 0.0 ? sqrtf((n * sigsumsq - sigsum * sigsum) / (n * (n - 1))) / (sigsum / n) * 100 : 0.0;	// units: % of mean signal strength
-  burst_par.freq     = freqsum / n;
+  bp.sig_sd   = sig_radicand >= 0.0 ? sqrtf((n * sigsumsq - sigsum * sigsum) / (n * (n - 1))) / (sigsum / n) * 100 : 0.0;	// units: % of mean signal strength
+  bp.freq     = freqsum / n;
   double freq_radicand = n * freqsumsq - freqsum * freqsum;
-  burst_par.freq_sd  = freq_radicand >= 0.0 ? sqrtf((n * freqsumsq - freqsum * freqsum) / (n * (n - 1))) : 0.0;
-  burst_par.slop     = slop;
-  burst_par.num_pred = hit_count;
+  bp.freq_sd  = freq_radicand >= 0.0 ? sqrtf((n * freqsumsq - freqsum * freqsum) / (n * (n - 1))) : 0.0;
+  bp.slop     = slop;
+  bp.num_pred = hit_count;
 };
 
 void Tag_Candidate::dump_bursts(short ant) {
@@ -300,15 +408,18 @@ void Tag_Candidate::dump_bursts(short ant) {
   if (pulses.size() < num_pulses)
     return;
 
-  auto p = pulses.begin();
-  while (p != pulses.end()) {
+  Pulse_Buffer burst_pulses;
+  Burst_Params burst_par;
+  pulses.copy_to(burst_pulses);
+  auto p = burst_pulses.begin();
+  while (p != burst_pulses.end()) {
     Timestamp ts = p->ts;
     if (++hit_count == 1) {
       // first hit, so start a run
       run_id = filer->begin_run(tag->motusID, ant, ts);
       Tag_Foray::num_cands_with_run_id(run_id, 1);
     }
-    calculate_burst_params(p); // advances p
+    calculate_burst_params(p, burst_par); // advances p
     filer->add_hit(
                    run_id,
                    ts,
@@ -357,7 +468,7 @@ Tag_Candidate::renTag(Tag * t1, Tag * t2) {
 
   // maintain the current confirmation level and pulse buffer;
   // subsequent hits will be reported as t2;
-  tag = t2;
+  set_tag(t2);
 }
 
 long long
@@ -387,7 +498,6 @@ DB_Filer * Tag_Candidate::filer = 0; // handle to output filer
 
 bool Tag_Candidate::ending_batch = false; // true iff we're ending a batch; set by Tag_Foray
 
-Burst_Params Tag_Candidate::burst_par;
 
 long long Tag_Candidate::num_cands = 0; // count of allocated but not freed candidates.
 long long Tag_Candidate::max_num_cands = 0; // count of allocated but not freed candidates.
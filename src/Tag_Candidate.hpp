@@ -5,10 +5,14 @@
 
 #include "Node.hpp"
 #include "Pulse.hpp"
+#include "Pulse_History.hpp"
 #include "Bounded_Range.hpp"
 #include "Freq_Setting.hpp"
 #include "Burst_Params.hpp"
 #include "DB_Filer.hpp"
+#include "Expiry_Index.hpp"
+#include "Graph_Table.hpp"
+#include "Cand_List.hpp"
 
 #include <map>
 #include <list>
@@ -37,7 +41,7 @@ protected:
 
   Tag_Finder    *owner;
   Node	        *state;		 // where in the appropriate DFA I am
-  Pulse_Buffer	 pulses;	 // pulses in the path so far
+  Pulse_History	 pulses;	 // pulses in the path so far; shared with candidates cloned from this one
   Timestamp	 last_ts;        // timestamp of last pulse accepted by this candidate
   Timestamp	 last_dumped_ts; // timestamp of last pulse in last dumped burst (used to calculate burst slop when dumping)
   Tag   	 *tag;           // current unique tag ID, if confirmed, or BOGUS_TAG when more than one is compatible
@@ -53,6 +57,22 @@ protected:
 
   // ------ END OF SERIALIZABLE MEMBERS ------
 
+  // where this candidate is in its owner's indexes; set by Tag_Finder
+  // and Expiry_Index
+
+  Timestamp list_key;           // key with which this candidate was inserted in its Cand_List
+  unsigned long long list_seq;  // seq assigned when this candidate was inserted in its Cand_List
+  size_t expiry_slot;           // position in owner's Expiry_Index
+  Tag_Candidate * tag_prev;     // previous candidate in owner's list of those with the same tag
+  Tag_Candidate * tag_next;     // next candidate in owner's list of those with the same tag
+  Tag_Candidate * node_prev;    // previous candidate in state's list of those at it
+  Tag_Candidate * node_next;    // next candidate in state's list of those at it
+
+  // where state is in the owner's Graph_Table; recomputed when the table is rebuilt
+
+  Graph_Table::State_ID sid;    // ID of state in the table of generation sid_gen
+  unsigned sid_gen;             // generation of the table sid is from; 0 if none
+
   static const float BOGUS_BURST_SLOP; // burst slop reported for first burst of run (where we don't have a previous burst)  Doesn't really matter, since we can distinguish this situation in the data by "pos.in.run==1"
 
   static Frequency_Offset_kHz freq_slop_kHz; // maximum width of frequency range of pulses (in MHz)
@@ -63,11 +83,9 @@ protected:
   static bool ending_batch; //!< true iff we're ending a batch; tells dtor whether to end run or not.
   static DB_Filer * filer;
 
-  // buffer used by calculate_burst_params
-  static Burst_Params burst_par;
-
   friend class Tag_Finder;
   friend class Ambiguity;
+  friend class Expiry_Index;
 
   static long long num_cands;
 
@@ -75,14 +93,30 @@ protected:
 
   static Timestamp max_cand_time;
 
+  const Graph_Table::State * frozen_state(); //!< state's entry in the owner's Graph_Table, or 0 if state has left the graph
+
+  Gap get_max_age(); //!< state->get_max_age(), from the Graph_Table where possible
+
+  void link_state(); //!< add this candidate to its state's list of candidates
+
+  void unlink_state(); //!< remove this candidate from its state's list of candidates, if it is in it
+
 public:
 
-  Tag_Candidate() {}; // default ctor for deserialization
+  Tag_Candidate(); // default ctor for deserialization
 
   Tag_Candidate(Tag_Finder *owner, Node *state, const Pulse &pulse);
 
   Tag_Candidate * clone();
 
+  // Candidates are allocated from their Tag_Finder's slab pool, by
+  // `new (owner) Tag_Candidate(...)`.  Candidates created by plain `new`
+  // (i.e. when deserializing) come from a pool shared by all finders.
+  static void * operator new(size_t size);
+  static void * operator new(size_t size, Tag_Finder * owner);
+  static void operator delete(void * p);
+  static void operator delete(void * p, Tag_Finder * owner);
+
   ~Tag_Candidate();
 
   void maybe_end_run(); //!< end run if this candidate has a valid run_id and no other candidates with that run_id still exist
@@ -97,10 +131,14 @@ public:
 
   Node * advance_by_pulse(const Pulse &p);
 
+  static void profile(Tag_Candidate * tc, Cand_List::Profile & pr); //!< get what Cand_List::filter needs to know about tc; a Cand_List::Profiler
+
   bool add_pulse(const Pulse &p, Node *new_state); //!< add a pulse, and return true if we can confirm the candidate owns this pulse.
 
   Tag * get_tag();
 
+  void set_tag(Tag * t); //!< set the tag, keeping owner's index of candidates by tag up to date
+
   Tag_ID_Level get_tag_id_level();
 
   bool is_confirmed();
@@ -113,7 +151,7 @@ public:
 
   void clear_pulses();
 
-  void calculate_burst_params(Pulse_Iter &p);
+  void calculate_burst_params(Pulse_Iter &p, Burst_Params & bp); //!< summarize the burst starting at p into bp, and advance p past it
 
   void dump_bursts(short prefix);
 
@@ -0,0 +1,68 @@
+#include "Tag_Edits.hpp"
+
+Tag_Edits::Tag_Edits() :
+  edits(),
+  nodes(),
+  ren_from()
+{
+};
+
+void
+Tag_Edits::record(bool added, std::pair < Tag *, Tag * > ren, Node::Journal & j) {
+  int i = edits.size();
+  edits.push_back(Edit {added, ren});
+  if (ren.first)
+    ren_from.insert(ren.first);
+
+  // j has a node's state before each change to it, so the first
+  // change in the batch gives its state before the batch; its state
+  // after this edit is the one it has now
+  for (auto & c : j) {
+    auto & h = nodes[c.n];
+    if (h.empty())
+      h.push_back(State {-1, c.unique, c.tag, c.min_age});
+    if (h.back().edit != i)
+      h.push_back(State {i, c.n->is_unique(), c.n->get_tag(), c.n->get_min_age()});
+  }
+  j.clear();
+};
+
+void
+Tag_Edits::get_changed(std::vector < Node * > & changed) const {
+  for (auto & n : nodes)
+    changed.push_back(n.first);
+};
+
+void
+Tag_Edits::get_renamed(std::vector < Tag * > & renamed) const {
+  renamed.insert(renamed.end(), ren_from.begin(), ren_from.end());
+};
+
+const Tag_Edits::State *
+Tag_Edits::state_after(Node * n, int i) const {
+  auto h = nodes.find(n);
+  if (h == nodes.end())
+    return 0;
+  auto s = h->second.rbegin();
+  while (s->edit > i)
+    ++s;
+  return & *s;
+};
+
+bool
+Tag_Edits::unique_after(Node * n, int i) const {
+  auto s = state_after(n, i);
+  return s ? s->unique : n->is_unique();
+};
+
+Tag *
+Tag_Edits::tag_after(Node * n, int i) const {
+  auto s = state_after(n, i);
+  return s ? s->tag : n->get_tag();
+};
+
+Gap
+Tag_Edits::min_age_after(Node * n, int i) const {
+  auto s = state_after(n, i);
+  return s ? s->min_age : n->get_min_age();
+};
@@ -0,0 +1,62 @@
+#ifndef TAG_EDITS_HPP
+#define TAG_EDITS_HPP
+
+#include "find_tags_common.hpp"
+#include "Node.hpp"
+
+/*
+  Tag_Edits - the changes made to one graph by a batch of tag events,
+  as seen by the Tag_Candidates walking it.
+
+  Tag_Foray applies all the tag events due before a pulse to the graphs
+  first, then has each Tag_Finder reclassify its candidates once for
+  the whole batch (see Tag_Finder::tags_changed).  To get the same
+  result as reclassifying after each event, the finder needs to know,
+  for each event, whether a tag was added or removed and what tag was
+  renamed, and for each node holding candidates, what its uniqueness,
+  tag and min age were after each event.  Nodes are recorded only if
+  an event changed their set or edges, from the Node::Journal kept
+  while the graph was edited; other nodes are as they are now.
+*/
+
+class Tag_Edits {
+
+public:
+
+  struct Edit {
+    bool added;                      //!< was a tag added, rather than removed?
+    std::pair < Tag *, Tag * > ren;  //!< tag renamed in the graph, as returned by Graph::addTag or delTag; (0, 0) if none
+  };
+
+  std::vector < Edit > edits;        //!< edits in the order they were made
+
+  Tag_Edits();
+
+  void record(bool added, std::pair < Tag *, Tag * > ren, Node::Journal & j); //!< record an edit which made the changes in j, then clear j
+
+  void get_changed(std::vector < Node * > & changed) const; //!< append the nodes any edit changed to changed
+
+  void get_renamed(std::vector < Tag * > & renamed) const; //!< append the tags any edit renamed to renamed
+
+  bool unique_after(Node * n, int i) const; //!< was n's set unique after the i'th edit?
+
+  Tag * tag_after(Node * n, int i) const; //!< n's (presumed unique) tag after the i'th edit
+
+  Gap min_age_after(Node * n, int i) const; //!< n's min age after the i'th edit
+
+protected:
+
+  struct State {
+    int edit;    //!< index of edit after which the node had this state; -1 before the first
+    bool unique;
+    Tag * tag;
+    Gap min_age;
+  };
+
+  std::unordered_map < Node *, std::vector < State > > nodes; //!< states of each node which was changed, in order of edit
+  TagSet ren_from; //!< tags renamed by any edit
+
+  const State * state_after(Node * n, int i) const; //!< n's recorded state after the i'th edit; 0 if n wasn't changed
+};
+
+#endif // TAG_EDITS_HPP
@@ -1,5 +1,17 @@
 #include "Tag_Finder.hpp"
 
+#include <algorithm>
+
+Tag_Finder::Tag_Finder() :
+  cand_pool(sizeof(Tag_Candidate)),
+  profile_gen(0)
+{};
+
+Tag_Finder::Tag_Finder(Tag_Foray * owner) :
+  cand_pool(sizeof(Tag_Candidate)),
+  profile_gen(0)
+{};
+
 Tag_Finder::Tag_Finder (Tag_Foray * owner, Nominal_Frequency_kHz nom_freq, TagSet *tags, Graph * g, string prefix) :
   owner(owner),
   nom_freq(nom_freq),
@@ -7,9 +19,13 @@ Tag_Finder::Tag_Finder (Tag_Foray * owner, Nominal_Frequency_kHz nom_freq, TagSe
   tags(tags),
   graph(g),
   cands(NUM_CAND_LISTS),
+  cand_pool(sizeof(Tag_Candidate)),
+  profile_gen(0),
   prefix(prefix)
 {
   sscanf(prefix.c_str(), "%hd", &ant);
+  for (auto & cs : cands)
+    cs.set_profiler(& Tag_Candidate::profile);
 };
 
 void
@@ -52,6 +68,18 @@ Tag_Finder::process(Pulse &p) {
   std::cerr << "Pulse " << p.ts << std::endl;
 #endif
 
+  delete_expired(p.ts);
+
+  // tag events since the last pulse may have changed the max ages
+  // of candidates' states
+  if (profile_gen != graph->get_table().get_gen()) {
+    for (int i = 0; i < NUM_CAND_LISTS; ++i)
+      cands[i].reprofile();
+    profile_gen = graph->get_table().get_gen();
+  }
+
+  static std::vector < unsigned char > visit;
+
   for (int i = 0; i < NUM_CAND_LISTS; ++i) {
 
     Cand_List & cs = cands[i];
@@ -61,19 +89,31 @@ Tag_Finder::process(Pulse &p) {
     dbg && std::cerr << "=== cand list " << i << " ===\n";
 #endif
 
-    Cand_List::iterator nextci; // "next" iterator in case we need to delete current one while traversing list
+    // candidates which can accept this pulse are in the ready region;
+    // we walk it by index, since removed entries are only cleared, and
+    // anything inserted while we walk goes after the current entry
+
+    cs.advance(p.ts);
 
-    for (Cand_List::iterator ci = cs.begin(); ci != cs.end() && p.ts >= ci->first; ci = nextci ) {
-      nextci = ci;
-      ++nextci;
+    // rule out in one pass the candidates which can't accept this
+    // pulse because of its frequency or signal strength, and which
+    // haven't expired; anything appended during the walk isn't covered
+
+    size_t num_filtered = cs.filter(p.ts, p.dfreq, p.sig, visit);
+
+    for (size_t k = 0; k < cs.num_ready() && p.ts >= cs.ready_at(k).key; ++k) {
+      if (k < num_filtered && ! visit[k])
+        continue;
+      Tag_Candidate * tc = cs.ready_at(k).tc;
+      if (! tc)
+        continue; // removed
 
 #ifdef DEBUG2
-      dbg && std::cerr << "Examining " << (void * ) (ci->second) << " last_ts " << (ci->second->last_ts) << std::endl;
+      dbg && std::cerr << "Examining " << (void * ) tc << " last_ts " << (tc->last_ts) << std::endl;
 #endif
       // check whether candidate has expired
-      if (ci->second->expired(p.ts)) {
-        auto tc = ci->second;
-        cs.erase(ci);
+      if (tc->expired(p.ts)) {
+        cs.remove_ready(k);
 #ifdef DEBUG2
         dbg && std::cerr << "Deleting " << (void *) tc << " last_ts " << (tc->last_ts)<< std::endl;
 #endif
@@ -82,43 +122,35 @@ Tag_Finder::process(Pulse &p) {
       }
 
       // check whether candidate can accept this pulse
-      Node * next_state = (ci->second)->advance_by_pulse(p);
+      Node * next_state = tc->advance_by_pulse(p);
 
       if (! next_state)
         continue;
 
-      // clone the candidate to fork over the "add pulse or don't add pulse" choice
+      // clone the candidate to fork over the "add pulse or don't add
+      // pulse" choice.  The clone has the same key, and takes the
+      // candidate's place in the list, so it is not examined again
+      // for this pulse.
 
-      Tag_Candidate * clone = (ci->second)->clone();
+      Tag_Candidate * clone = tc->clone();
+      cs.ready_at(k).tc = clone;
+      expiries.add(clone);
 
 #ifdef DEBUG2
-      dbg && std::cerr << "Cloned " << (void *) (ci->second) << " last_ts " << (ci->second->last_ts) << " as " << (void *) clone << std::endl;
+      dbg && std::cerr << "Cloned " << (void *) tc << " last_ts " << (tc->last_ts) << " as " << (void *) clone << std::endl;
 #endif
-      // NB: DANGEROUS ASSUMPTION!!  Because we've already computed
-      // the next value for ci as nextci, inserting the clone (which
-      // has the same key as ci does before it accepts the pulse) into
-      // the same Cand_List at the position for ci *should* mean the
-      // clone is not reached on the remaining iterations of the
-      // current loop.  This assumes the hinted insert is placing the
-      // new element either before or after the hint, since they share
-      // a key.  This assumption will fail if the hinted insert method
-      // ever places the new element later in the portion of the list
-      // sharing the same key, and if the candidate pointed to
-      // by nextci also has the same key.  If the algorithm crashes
-      // due to out of memory, we'll know not to do this!
-
-      cs.insert(ci, std::make_pair(clone->min_next_pulse_ts(), clone));
 
       // add the pulse
-      Tag_Candidate * tc = ci->second;
-      if (tc->add_pulse(p, next_state)) {
+      bool owns = tc->add_pulse(p, next_state);
+      expiries.update(tc);
+      if (owns) {
         // this candidate has confirmed ownership of the pulse
 
         // delete any other candidate sharing any pulse with this one
-        delete_competitors(ci, nextci);
+        delete_competitors(tc);
 
         // dump all complete bursts from this confirmed tag
-        (ci->second)->dump_bursts(ant);
+        tc->dump_bursts(ant);
 
         // mark that this pulse has been accepted by a candidate at the CONFIRMED level
         confirmed_acceptance = true;
@@ -127,66 +159,166 @@ Tag_Finder::process(Pulse &p) {
       // this candidate has accepted a pulse, and needs to be re-indexed
       // within its Cand_list, which might also have changed.
 
-      cands[ci->second->tag_id_level].insert(std::make_pair((ci->second)->min_next_pulse_ts(), ci->second));
-      cs.erase(ci);
+      enlist(tc);
 
       if (confirmed_acceptance) {
         // we won't try to add this pulse to other candidates
-        // so quit booth loops
-
-        i = NUM_CAND_LISTS;
         break;
       }
     } // continue trying letting other tag_candidates try this pulse
 
+    cs.compact();
+
+    if (confirmed_acceptance)
+      break;
   }
   // maybe start a new Tag_Candidate with this pulse
   if (! confirmed_acceptance) {
-    auto ntc = new Tag_Candidate(this, graph->root(), p);
-    cands[Tag_Candidate::MULTIPLE].insert(std::make_pair(ntc->min_next_pulse_ts(), ntc));
+    auto ntc = new (this) Tag_Candidate(this, graph->root(), p);
+    enlist(ntc);
+    expiries.add(ntc);
   }
 };
 
 
 Tag_Finder::~Tag_Finder() {
   // dump any confirmed candidates which have bursts
-  // delete them even if not
-  for (Cand_List::iterator ci = cands[0].begin(); ci != cands[0].end(); ++ci ) {
-
-    if ((ci->second)->get_tag_id_level() == Tag_Candidate::CONFIRMED && (ci->second)->has_burst()) {
+  // delete them even if not; unconfirmed candidates must be
+  // deleted too, since they are linked into the cands lists
+  // of nodes shared with other finders on the same graph,
+  // and their storage goes with cand_pool
+  std::vector < Cand_List::Entry > all;
+  for (int i = 0; i < NUM_CAND_LISTS; ++i)
+    cands[i].get_all(all);
+  for (auto & e : all) {
+
+    if (e.tc->get_tag_id_level() == Tag_Candidate::CONFIRMED && e.tc->has_burst()) {
       // dump remaining bursts
-      (ci->second)->dump_bursts(ant);
+      e.tc->dump_bursts(ant);
     }
-    delete (ci->second);
+    delete e.tc;
   }
 };
 
 void
-Tag_Finder::delete_competitors(Cand_List::iterator ci, Cand_List::iterator &nextci) {
-  // drop any candidates for the same tag as ci, or sharing any pulses
-  // with it.  We do this when ci has just accepted a pulse that completes
-  // a burst at the CONFIRMED tag_id_level
+Tag_Finder::enlist(Tag_Candidate * tc) {
+  tc->list_key = tc->min_next_pulse_ts();
+  tc->list_seq = cands[tc->tag_id_level].insert(tc->list_key, tc);
+};
 
-  // nextci is bumped up in case we delete the candidate it points to
-
-  for (int j = 0; j < NUM_CAND_LISTS; ++j) {
-    for (Cand_List::iterator cci = cands[j].begin(); cci != cands[j].end(); /**/ ) {
-      if ((cci->second) != (ci->second)
-          && ((cci->second)->has_same_id_as(ci->second)
-              || (cci->second)->shares_any_pulses(ci->second))) {
-        Cand_List::iterator di = cci;
-        ++cci;
-        auto p = di->second;
-        if (nextci == di) {
-          ++nextci;
-        }
-        cands[j].erase(di);
-        delete p;
-      } else {
-        ++cci;
-      }
+void
+Tag_Finder::delete_expired(Timestamp now) {
+  // Delete candidates in order of expiry time, so that those whose
+  // lists aren't scanned for a while don't pile up.  A candidate
+  // whose computed expiry time is before now only by rounding is
+  // set aside until the next pulse.
+
+  static std::vector < Tag_Candidate * > not_yet;
+
+  while (! expiries.empty() && expiries.first_ts() < now) {
+    Tag_Candidate * tc = expiries.first();
+    if (! tc->expired(now)) {
+      expiries.remove(tc);
+      not_yet.push_back(tc);
+      continue;
+    }
+    cands[tc->tag_id_level].remove(tc->list_key, tc->list_seq);
+    delete tc;
+  }
+  for (auto tc : not_yet)
+    expiries.add(tc);
+  not_yet.clear();
+};
+
+void
+Tag_Finder::index_cands() {
+  std::vector < Cand_List::Entry > all;
+  for (int i = 0; i < NUM_CAND_LISTS; ++i) {
+    cands[i].set_profiler(& Tag_Candidate::profile);
+    all.clear();
+    cands[i].get_all(all);
+    for (auto & e : all) {
+      e.tc->list_key = e.key;
+      e.tc->list_seq = e.seq;
+      expiries.add(e.tc);
+      index_tag(e.tc);
+      e.tc->link_state();
     }
   }
+  Pulse_History::end_load();
+};
+
+void
+Tag_Finder::index_tag(Tag_Candidate * tc) {
+  if (tc->tag == BOGUS_TAG)
+    return;
+  auto & first = by_tag[tc->tag];
+  tc->tag_prev = 0;
+  tc->tag_next = first;
+  if (first)
+    first->tag_prev = tc;
+  first = tc;
+};
+
+void
+Tag_Finder::unindex_tag(Tag_Candidate * tc) {
+  if (tc->tag == BOGUS_TAG)
+    return;
+  if (tc->tag_prev) {
+    tc->tag_prev->tag_next = tc->tag_next;
+  } else {
+    auto i = by_tag.find(tc->tag);
+    if (i == by_tag.end() || i->second != tc)
+      return; // not indexed
+    if (tc->tag_next)
+      i->second = tc->tag_next;
+    else
+      by_tag.erase(i);
+  }
+  if (tc->tag_next)
+    tc->tag_next->tag_prev = tc->tag_prev;
+  tc->tag_prev = tc->tag_next = 0;
+};
+
+void
+Tag_Finder::delete_competitors(Tag_Candidate * tc) {
+  // drop any candidates for the same tag as tc, or sharing any pulses
+  // with it.  We do this when tc has just accepted a pulse that completes
+  // a burst at the CONFIRMED tag_id_level
+
+  // Find them from the index of candidates by tag, and from the pulse
+  // histories, then delete them in list order, as a scan of the lists
+  // would.
+
+  static std::vector < Tag_Candidate * > doomed;
+  doomed.clear();
+
+  if (tc->tag != BOGUS_TAG) {
+    auto i = by_tag.find(tc->tag);
+    if (i != by_tag.end())
+      for (Tag_Candidate * c = i->second; c; c = c->tag_next)
+        doomed.push_back(c);
+  }
+  tc->pulses.get_sharers(doomed);
+
+  std::sort(doomed.begin(), doomed.end(), [] (Tag_Candidate * a, Tag_Candidate * b) {
+      if (a->tag_id_level != b->tag_id_level)
+        return a->tag_id_level < b->tag_id_level;
+      if (a->list_key != b->list_key)
+        return a->list_key < b->list_key;
+      if (a->list_seq != b->list_seq)
+        return a->list_seq < b->list_seq;
+      // tc's clone has taken tc's place in its list
+      return a < b;
+    });
+  doomed.erase(std::unique(doomed.begin(), doomed.end()), doomed.end());
+
+  for (auto c : doomed) {
+    if (c == tc)
+      continue;
+    cands[c->tag_id_level].remove(c->list_key, c->list_seq);
+    delete c;
+  }
 };
 
 Gap *
@@ -202,76 +334,101 @@ Tag_Finder::dump_bogus_burst(Pulse &p) {
 };
 
 void
-Tag_Finder::tag_added(std::pair < Tag *, Tag * > tp) {
-  // possibly rename a tag, due to it now being ambiguous
-  if (tp.first)
-    rename_tag(tp);
-  // check for candidates at level SINGLE which might now
-  // be at level MULTIPLE
-  Cand_List & cs = cands[Tag_Candidate::SINGLE];
-  Cand_List::iterator nextci; // "next" iterator in case we need to delete current one while traversing list
-  for (Cand_List::iterator ci = cs.begin(); ci != cs.end(); ci = nextci ) {
-    nextci = ci;
-    ++nextci;
-    Tag_Candidate *tc = ci->second;
-    if (! tc->state->is_unique()) {
-      tc->tag_id_level = Tag_Candidate::MULTIPLE;
-      tc->tag = BOGUS_TAG;
-      cands[tc->tag_id_level].insert(std::make_pair((ci->second)->min_next_pulse_ts(), ci->second));
-      cs.erase(ci);
-    }
+Tag_Finder::tags_changed(const Tag_Edits & te) {
+  // For each edit, rename candidates having a tag the edit renamed,
+  // then move SINGLE candidates whose node is no longer unique to
+  // MULTIPLE if it added a tag, or MULTIPLE candidates whose node is
+  // now unique to SINGLE if it removed one.  Only candidates this
+  // could affect are looked at: those at nodes which were changed,
+  // found from each node's list of its candidates, those with a
+  // renamed tag, found from by_tag, and those at the root, where new
+  // candidates start, whether or not an edit changed it (one which
+  // replaces an ambiguity with itself leaves the root's set as it
+  // was).  Any other candidate keeps its level and tag throughout:
+  // its node's uniqueness doesn't change, and only matches its level,
+  // since a candidate's level is checked against its node whenever it
+  // moves.
+  // So the cost doesn't depend on how many candidates there are.
+  // Candidates are renamed and moved in list order, and a moved
+  // candidate's key is from its node's min age after that edit.
+
+  std::vector < Tag_Candidate * > affected;
+  std::vector < Node * > changed;
+  te.get_changed(changed);
+  changed.push_back(graph->root());
+  for (auto n : changed)
+    for (auto tc = n->cands; tc; tc = tc->node_next)
+      if (tc->owner == this)
+        affected.push_back(tc);
+  std::vector < Tag * > renamed;
+  te.get_renamed(renamed);
+  for (auto t : renamed) {
+    auto i = by_tag.find(t);
+    if (i != by_tag.end())
+      for (auto tc = i->second; tc; tc = tc->tag_next)
+        affected.push_back(tc);
   }
-}
-
-void
-Tag_Finder::tag_removed(std::pair < Tag *, Tag * > tp) {
-  // possibly rename a tag, due to it now being ambiguous
-  if (tp.first)
-    rename_tag(tp);
-  // check for candidates at level MULTIPLE which might now
-  // be at level SINGLE
-  Cand_List & cs = cands[Tag_Candidate::MULTIPLE];
-  Cand_List::iterator nextci; // "next" iterator in case we need to delete current one while traversing list
-  for (Cand_List::iterator ci = cs.begin(); ci != cs.end(); ci = nextci ) {
-    nextci = ci;
-    ++nextci;
-    Tag_Candidate *tc = ci->second;
-    if (tc->state->is_unique()) {
-      tc->tag_id_level = Tag_Candidate::SINGLE;
-      tc->tag = tc->state->get_tag();
-      tc->num_pulses = tc->tag->gaps.size();
-      cands[tc->tag_id_level].insert(std::make_pair((ci->second)->min_next_pulse_ts(), ci->second));
-      cs.erase(ci);
+  if (affected.empty())
+    return;
+  std::sort(affected.begin(), affected.end());
+  affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+  auto list_order = [] (Tag_Candidate * a, Tag_Candidate * b) {
+    return a->tag_id_level < b->tag_id_level
+    || (a->tag_id_level == b->tag_id_level
+        && (a->list_key < b->list_key || (a->list_key == b->list_key && a->list_seq < b->list_seq)));
+  };
+
+  std::vector < Tag_Candidate * > todo;
+  for (int i = 0; i < (int) te.edits.size(); ++i) {
+    auto & ed = te.edits[i];
+
+    // rename candidates with the renamed tag, other than MULTIPLE ones
+    if (ed.ren.first) {
+      todo.clear();
+      for (auto tc : affected)
+        if (tc->tag_id_level != Tag_Candidate::MULTIPLE && tc->tag == ed.ren.first)
+          todo.push_back(tc);
+      std::sort(todo.begin(), todo.end(), list_order);
+      for (auto tc : todo)
+        tc->renTag(ed.ren.first, ed.ren.second);
     }
-  }
-}
-
 
-void
-Tag_Finder::rename_tag(std::pair < Tag *, Tag * > tp) {
-  for (int i = 0; i < 2; ++i) {
-    Cand_List & cs = cands[i];
-    for (Cand_List::iterator ci = cs.begin(); ci != cs.end(); ++ci )
-      (ci->second)->renTag(tp.first, tp.second);
+    // move SINGLE candidates whose node is no longer unique to
+    // MULTIPLE, or MULTIPLE candidates whose node now is to SINGLE
+    auto from = ed.added ? Tag_Candidate::SINGLE : Tag_Candidate::MULTIPLE;
+    todo.clear();
+    for (auto tc : affected)
+      if (tc->tag_id_level == from && te.unique_after(tc->state, i) != ed.added)
+        todo.push_back(tc);
+    std::sort(todo.begin(), todo.end(), list_order);
+    for (auto tc : todo)
+      cands[from].remove(tc->list_key, tc->list_seq);
+    for (auto tc : todo) {
+      if (ed.added) {
+        tc->tag_id_level = Tag_Candidate::MULTIPLE;
+        tc->set_tag(BOGUS_TAG);
+      } else {
+        tc->tag_id_level = Tag_Candidate::SINGLE;
+        tc->set_tag(te.tag_after(tc->state, i));
+        tc->num_pulses = tc->tag->gaps.size();
+      }
+      tc->list_key = tc->last_ts + te.min_age_after(tc->state, i);
+      tc->list_seq = cands[tc->tag_id_level].insert(tc->list_key, tc);
+    }
   }
 };
 
 void
 Tag_Finder::reap(Timestamp now) {
 
+  std::vector < Tag_Candidate * > expired;
   for (int i = 0; i < NUM_CAND_LISTS; ++i) {
-    Cand_List & cs = cands[i];
-    for (Cand_List::iterator ci = cs.begin(); ci != cs.end(); /**/ ) {
-      if ((ci->second)->expired(now)) {
-        Cand_List::iterator di = ci;
-        ++ci;
-        auto pdi = di->second;
-        cs.erase(di);
-        delete pdi;
-      } else {
-        ++ci;
-      }
-    }
+    expired.clear();
+    cands[i].remove_if([now] (Tag_Candidate * tc) { return tc->expired(now); }, expired);
+    for (auto tc : expired)
+      delete tc;
+    cands[i].compact();
   }
   last_reap = now;
 }
@@ -279,12 +436,14 @@ Tag_Finder::reap(Timestamp now) {
 void
 Tag_Finder::dump(Timestamp latest) {
   std::cerr << "Tag_Finder::dump @ " << std::setprecision(14) << latest << std::endl;
+  std::vector < Cand_List::Entry > all;
   for (int i = 0; i < NUM_CAND_LISTS; ++i) {
     std::cerr << "List " << i << std::endl;
 
-    Cand_List & cs = cands[i];
-    for (Cand_List::iterator ci = cs.begin(); ci != cs.end(); ++ci) {
-      std::cerr << "Candidate with " << ci->second->pulses.size() << " pulses (ID_level = " << ci->second->tag_id_level << ", hit count=" << ci->second->hit_count << ") min next pulse ts: " << ci->second->min_next_pulse_ts() << "," << " expired? " << (ci->second)->expired(latest) << std::endl;
+    all.clear();
+    cands[i].get_all(all);
+    for (auto & e : all) {
+      std::cerr << "Candidate with " << e.tc->pulses.size() << " pulses (ID_level = " << e.tc->tag_id_level << ", hit count=" << e.tc->hit_count << ") min next pulse ts: " << e.tc->min_next_pulse_ts() << "," << " expired? " << e.tc->expired(latest) << std::endl;
     }
   }
 }
@@ -9,6 +9,10 @@
 #include "Event.hpp"
 #include "History.hpp"
 #include "Ticker.hpp"
+#include "Slab_Pool.hpp"
+#include "Cand_List.hpp"
+#include "Expiry_Index.hpp"
+#include "Tag_Edits.hpp"
 #include <boost/serialization/list.hpp>
 
 class Tag_Foray;
@@ -21,12 +25,8 @@ class Tag_Finder;
 
 #include "Tag_Candidate.hpp"
 
-// Set of running DFAs representing possible tags burst sequences
-//typedef std::list < Tag_Candidate * > Cand_List;
-
-// candidate list sorted in order of smallest gap they are ready
-// to accept
-typedef std::multimap < Gap, Tag_Candidate * > Cand_List;
+// Set of running DFAs representing possible tags burst sequences,
+// one Cand_List per Tag_ID_Level
 
 typedef std::vector < Cand_List > Cand_List_Vec;
 
@@ -57,6 +57,14 @@ public:
 
   Cand_List_Vec	cands;
 
+  Expiry_Index expiries; // all candidates, by when they expire
+
+  std::unordered_map < Tag *, Tag_Candidate * > by_tag; // first of the candidates with each tag, other than BOGUS_TAG
+
+  Slab_Pool cand_pool; // storage for Tag_Candidates created by this finder
+
+  unsigned profile_gen; // generation of graph's Graph_Table when candidates' Cand_List profiles were taken
+
   // algorithmic parameters
 
 
@@ -66,9 +74,9 @@ public:
 
   short ant;       // antenna value, interpreted from prefix
 
-  Tag_Finder() {}; //!< default ctor for deserialization
+  Tag_Finder(); //!< default ctor for deserialization
 
-  Tag_Finder(Tag_Foray * owner) {};
+  Tag_Finder(Tag_Foray * owner);
 
   Tag_Finder (Tag_Foray * owner, Nominal_Frequency_kHz nom_freq, TagSet * tags, Graph * g, string prefix="");
 
@@ -82,18 +90,24 @@ public:
 
   void dump_bogus_burst(Pulse &p);
 
-  void tag_added(std::pair < Tag *, Tag * > tp); //!< perform any fixups due to a tag having been added to the graph
-
-  void tag_removed(std::pair < Tag *, Tag * > tp); //!< perform any fixups due to a tag having been removed from the graph
-
-  void rename_tag(std::pair < Tag *, Tag * > tp); //!< rename a tag, due to addition or removal of ambiguity
+  void tags_changed(const Tag_Edits & te); //!< rename and reclassify candidates after each of a batch of edits to the graph, as tags were added, removed, or renamed due to ambiguity
 
   void reap(Timestamp now); //!< reap all tag candidates which have expired by time now; used in case pulse stream from a given
   // slot ends, so we can free up memory and correctly end runs.
 
+  void index_cands(); //!< record list positions of, and index expiry times for, all candidates, after deserialization
+
   void dump(Timestamp latest); //!< for debugging, dump all current candidates with numbers of pulses and min_timestamp
 
-  void delete_competitors(Cand_List::iterator ci, Cand_List::iterator &nextci); //!< delete any candidates for the same tag or sharing any pulses with * ci
+  void enlist(Tag_Candidate * tc); //!< insert tc in the Cand_List for its tag_id_level
+
+  void delete_expired(Timestamp now); //!< delete all candidates which have expired by time now
+
+  void index_tag(Tag_Candidate * tc); //!< add tc to the list of candidates with its tag
+
+  void unindex_tag(Tag_Candidate * tc); //!< remove tc from the list of candidates with its tag
+
+  void delete_competitors(Tag_Candidate * tc); //!< delete any candidates for the same tag or sharing any pulses with tc
 
 public:
 
@@ -108,6 +122,9 @@ public:
     ar & BOOST_SERIALIZATION_NVP( cands );
     ar & BOOST_SERIALIZATION_NVP( prefix );
 
+    if (Archive::is_loading::value)
+      index_cands();
+
     sscanf(prefix.c_str(), "%hd", &ant);
   };
 };
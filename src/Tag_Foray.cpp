@@ -3,12 +3,19 @@
 
 #include <string.h>
 #include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <functional>
 #include <time.h>
+#include <unistd.h>
 #include <cmath>
 
 Tag_Foray::Tag_Foray () :  // default ctor for deserializing into
+  cache(0),
+  graph_cache(),
   line_no(0),   // line numbers reset even when resuming
   pulse_count(MAX_PORT_NUM + 1 + NUM_SPECIAL_PORTS),
+  port_slots(MAX_PORT_NUM + 1 + NUM_SPECIAL_PORTS),
   hist(0),      // we recreate history on resume
   tsBegin(0),
   prevHourBin(0)
@@ -17,6 +24,8 @@ Tag_Foray::Tag_Foray () :  // default ctor for deserializing into
 Tag_Foray::Tag_Foray (Tag_Database * tags, Data_Source *data, Frequency_MHz default_freq, bool force_default_freq, float min_dfreq, float max_dfreq, float max_pulse_rate, Gap pulse_rate_window, Gap min_bogus_spacing, bool unsigned_dfreq, bool pulses_only) :
   tags(tags),
   data(data),
+  cache(0),
+  graph_cache(),
   default_freq(default_freq),
   force_default_freq(force_default_freq),
   min_dfreq(min_dfreq),
@@ -28,6 +37,7 @@ Tag_Foray::Tag_Foray (Tag_Database * tags, Data_Source *data, Frequency_MHz defa
   pulses_only(pulses_only),
   line_no(0),
   pulse_count(MAX_PORT_NUM + 1 + NUM_SPECIAL_PORTS),
+  port_slots(MAX_PORT_NUM + 1 + NUM_SPECIAL_PORTS),
   ts(0),
   pulse_slop(default_pulse_slop),
   burst_slop(default_burst_slop),
@@ -79,6 +89,46 @@ Tag_Foray::set_timestamp_wonkiness(unsigned int w) {
   timestamp_wonkiness = w;
 };
 
+void
+Tag_Foray::set_record_cache(Record_Cache * rc) {
+  cache = rc;
+};
+
+void
+Tag_Foray::set_graph_cache(std::string dir) {
+  graph_cache = dir;
+};
+
+bool
+Tag_Foray::next_record(SG_Record & r) {
+  if (data->has_corrected_timestamps())
+    return data->get_record(r);
+  if (! cr->get(r))
+    return false;
+  if (cache)
+    cache->put(r);
+  return true;
+};
+
+void
+Tag_Foray::end_record_cache() {
+  if (! cache)
+    return;
+
+  // save the data source's state as pause() does, so that a run which
+  // reads the cache leaves the same state for a later --resume
+  std::ostringstream ofs;
+  {
+    boost::archive::binary_oarchive oa(ofs, boost::archive::no_header);
+    data->serialize(oa, SERIALIZATION_VERSION);
+  }
+  Timestamp tsLow, tsHigh, by, error;
+  cr->get_time_fix(tsLow, tsHigh, by, error);
+  cache->finish(ofs.str(), tsLow, tsHigh, by, error);
+  delete cache;
+  cache = 0;
+};
+
 void
 Tag_Foray::start() {
   Tag_Candidate::ending_batch = false;
@@ -86,8 +136,10 @@ Tag_Foray::start() {
   cr = new Clock_Repair(data, &line_no, Tag_Candidate::filer);
   SG_Record r;
 
-  if (! cr->get(r))
+  if (! next_record(r)) {
+    end_record_cache();
     return;  // no records, so nothing to do
+  }
 
   // the record returned by cr has a valid timestamp (the whole point of Clock_Repair)
   // so we can prune events corresponding to a tag having been activated and then died
@@ -98,7 +150,8 @@ Tag_Foray::start() {
   cron = hist->getTicker();
 
   bool have_record = true;
-  for( ; have_record; have_record = cr->get(r)) {
+  bool first_pulse = true;
+  for( ; have_record; have_record = next_record(r)) {
     // get begin time, allowing for small time reversals (10 seconds)
     if (! tsBegin || (r.ts < tsBegin && r.ts >= tsBegin - 10.0)) {
       tsBegin = r.ts;
@@ -134,8 +187,11 @@ Tag_Foray::start() {
         continue;
       }
 
-      if (! force_default_freq)
+      if (! force_default_freq) {
         port_freq[r.port] = Freq_Setting(r.v.param_value);
+        if (r.port >= - NUM_SPECIAL_PORTS && r.port <= MAX_PORT_NUM)
+          port_slots[r.port + NUM_SPECIAL_PORTS].valid = false;
+      }
       continue;
       break;
 
@@ -163,46 +219,34 @@ Tag_Foray::start() {
         if (r.v.dfreq > max_dfreq || r.v.dfreq < min_dfreq)
           continue;
 
-        Tag_Finder_Key key;
-
-        if (! pulses_only) {
-          // NB: cast r.port to work around optimization of passing reference
-          // to packed struct
+        // tag events before the first pulse activate all the tags
+        // deployed by then, so are processed in bulk, before any
+        // Tag_Finder holds a graph (which might be replaced from the
+        // graph cache)
 
-          // which tag finder should this pulse be passed to?  There is at
-          // least a tag finder on each port, and possibly more than one if
-          // the listening frequency is changing.
+        if (first_pulse) {
+          process_events_in_bulk(r.ts);
+          first_pulse = false;
+        }
 
-          key = Tag_Finder_Key((short int) r.port, port_freq[r.port].f_kHz);
+        // which tag finder should this pulse be passed to?  There is at
+        // least a tag finder on each port, and possibly more than one if
+        // the listening frequency is changing.
 
-          // if there isn't already an appropriate Tag_Finder, create it
-          if (! tag_finders.count(key)) {
-            Tag_Finder *newtf;
-            std::ostringstream prefix;
-            prefix << r.port << ",";
-            if (max_pulse_rate > 0)
-              newtf = new Rate_Limiting_Tag_Finder(this, key.second, tags->get_tags_at_freq(key.second), graphs[key.second], pulse_rate_window, max_pulse_rate, min_bogus_spacing, prefix.str());
-            else
-              newtf = new Tag_Finder(this, key.second, tags->get_tags_at_freq(key.second), graphs[key.second], prefix.str());
-            tag_finders[key] = newtf;
-#ifdef DEBUG3
-            std::cerr << "Interval Tree for " << prefix.str() << std::endl;
-            newtf->graph.get_root()->dump(std::cerr);
-            std::cerr << "Burst slop expansion is " << Tag_Finder::default_burst_slop_expansion << std::endl;
-#endif
-          };
-        }
+        Port_Slot other = {false, 0, 0};
+        Port_Slot & ps = (r.port >= - NUM_SPECIAL_PORTS && r.port <= MAX_PORT_NUM) ? port_slots[r.port + NUM_SPECIAL_PORTS] : other;
+        if (! ps.valid)
+          fill_port_slot(r.port, ps);
 
         if (r.v.dfreq < 0 && unsigned_dfreq)
           r.v.dfreq = - r.v.dfreq;
 
         // create a pulse object from this record
-        Pulse p = Pulse::make(r.ts, r.v.dfreq, r.v.sig, r.v.noise, port_freq[r.port].f_MHz);
+        Pulse p = Pulse::make(r.ts, r.v.dfreq, r.v.sig, r.v.noise, ps.f_MHz);
 
         // process any tag events up to this point in time
-
-        while (cron.ts() <= p.ts)
-          process_event(cron.get());
+        if (cron.ts() <= p.ts)
+          process_events(p.ts);
 
 #ifdef ACTIVE_TAG_DIAGNOSTICS
         if (active_tag_dump_interval > 0.0 && p.ts > next_active_tag_dump_time) {
@@ -219,9 +263,9 @@ Tag_Foray::start() {
 #ifdef DEBUG2
           std::cerr << p.ts << ": Key: " << r.port << ", " << port_freq[r.port].f_kHz << std::endl;
 #endif
-          tag_finders[key]->process(p);
+          ps.tf->process(p);
 #ifdef DEBUG3
-          tag_finders[key]->dump(r.ts);
+          ps.tf->dump(r.ts);
 #endif
         }
       }
@@ -235,6 +279,8 @@ Tag_Foray::start() {
       break;
     }
   }
+  end_record_cache();
+
   // record pulse counts from the last hour bin
 
   for (int i = 0; i < pulse_count.size(); ++i)
@@ -242,8 +288,58 @@ Tag_Foray::start() {
       Tag_Candidate::filer->add_pulse_count(prevHourBin, i - NUM_SPECIAL_PORTS, pulse_count[i]);
 };
 
+void
+Tag_Foray::fill_port_slot(Port_Num port, Port_Slot & ps) {
+  ps.f_MHz = port_freq[port].f_MHz;
+  ps.tf = 0;
+  ps.valid = true;
+  if (pulses_only)
+    return;
+
+  auto key = Tag_Finder_Key(port, port_freq[port].f_kHz);
+  auto i = tag_finders.find(key);
+  if (i != tag_finders.end()) {
+    ps.tf = i->second;
+    return;
+  }
+
+  // there isn't already an appropriate Tag_Finder, so create it
+  Tag_Finder *newtf;
+  std::ostringstream prefix;
+  prefix << port << ",";
+  if (max_pulse_rate > 0)
+    newtf = new Rate_Limiting_Tag_Finder(this, key.second, tags->get_tags_at_freq(key.second), graphs[key.second], pulse_rate_window, max_pulse_rate, min_bogus_spacing, prefix.str());
+  else
+    newtf = new Tag_Finder(this, key.second, tags->get_tags_at_freq(key.second), graphs[key.second], prefix.str());
+  tag_finders[key] = newtf;
+  ps.tf = newtf;
+#ifdef DEBUG3
+  std::cerr << "Interval Tree for " << prefix.str() << std::endl;
+  newtf->graph.get_root()->dump(std::cerr);
+  std::cerr << "Burst slop expansion is " << Tag_Finder::default_burst_slop_expansion << std::endl;
+#endif
+};
+
 void
 Tag_Foray::process_event(Event e) {
+  Tag_Edits te;
+  Node::Journal journal;
+  Node::journal = & journal;
+  std::pair < Tag *, Tag * > rv;
+  bool changed = edit_graph(e, rv);
+  if (changed)
+    te.record(e.code == Event::E_ACTIVATE, rv, journal);
+  Node::journal = 0;
+  if (! changed)
+    return;
+  auto fs = Freq_Setting::as_Nominal_Frequency_kHz(e.tag->freq);
+  for (auto i = tag_finders.begin(); i != tag_finders.end(); ++i)
+    if (i->first.second == fs)
+      i->second->tags_changed(te);
+}
+
+bool
+Tag_Foray::edit_graph(Event e, std::pair < Tag *, Tag * > & rv) {
   auto t = e.tag;
   auto fs = Freq_Setting::as_Nominal_Frequency_kHz(t->freq);
   Graph * g = graphs[fs];
@@ -251,8 +347,8 @@ Tag_Foray::process_event(Event e) {
   case Event::E_ACTIVATE:
     {
       if (t->active)
-        return;
-      auto rv = g->addTag(t, pulse_slop, burst_slop / 4.0, (1 + max_skipped_bursts) * 4.0, timestamp_wonkiness);
+        return false;
+      rv = g->addTag(t, pulse_slop, burst_slop / 4.0, (1 + max_skipped_bursts) * 4.0, timestamp_wonkiness);
 #ifdef DEBUG2
       g->viz();
 #endif
@@ -263,20 +359,17 @@ Tag_Foray::process_event(Event e) {
       // later (the assert in Graph::find() fails)
       rv.second && (rv.second->active = true);
 
-      for (auto i = tag_finders.begin(); i != tag_finders.end(); ++i)
-        if (i->first.second == fs)
-          i->second->tag_added(rv);
       t->active = true;
 #ifdef DEBUG2
       std::cerr << "Activating " << t->motusID << "=" << (void *) t << std::endl;
 #endif
     }
-    break;
+    return true;
   case Event::E_DEACTIVATE:
     {
       if (! t->active)
-        return;
-      auto rv = g->delTag(t);
+        return false;
+      rv = g->delTag(t);
 #ifdef DEBUG2
       g->viz();
 #endif
@@ -286,20 +379,239 @@ Tag_Foray::process_event(Event e) {
       rv.first && (rv.first->active = false);
       rv.second && (rv.second->active = true);
 
-      for (auto i = tag_finders.begin(); i != tag_finders.end(); ++i)
-        if (i->first.second == fs)
-          i->second->tag_removed(rv);
       t->active = false;
 #ifdef DEBUG2
       std::cerr << "Deactivating " << t->motusID << "=" << (void *) t << std::endl;
 #endif
     }
-    break;
+    return true;
   default:
     std::cerr << "Warning: Unknown event code " << e.code << " for tag " << t->motusID << std::endl;
   };
+  return false;
 }
 
+void
+Tag_Foray::process_events(Timestamp ts) {
+  // Tag events often come in batches with the same timestamp, as when
+  // many tags are deployed together.  Rather than have each Tag_Finder
+  // scan its candidates after each event, edit the graphs for all of
+  // them, noting which nodes holding candidates change, then have each
+  // Tag_Finder reclassify its candidates once.
+
+  std::map < Nominal_Frequency_kHz, Tag_Edits > edits;
+  Node::Journal journal;
+  Node::journal = & journal;
+  while (cron.ts() <= ts) {
+    Event e = cron.get();
+    std::pair < Tag *, Tag * > rv;
+    if (edit_graph(e, rv))
+      edits[Freq_Setting::as_Nominal_Frequency_kHz(e.tag->freq)].record(e.code == Event::E_ACTIVATE, rv, journal);
+  }
+  Node::journal = 0;
+
+  for (auto & i : tag_finders) {
+    auto j = edits.find(i.first.second);
+    if (j != edits.end())
+      i.second->tags_changed(j->second);
+  }
+}
+
+void
+Tag_Foray::process_events_in_bulk(Timestamp ts) {
+  // Graphs defer compiling nodes while adding tags in bulk, so tag
+  // candidates mustn't walk them until they're done; that can only
+  // happen if there are any candidates.
+
+  if (Tag_Candidate::get_num_cands() > 0)
+    return;
+
+  // the graphs built depend only on the tags, the events and the
+  // timing parameters, so a fresh foray can load them from the graph
+  // cache if another run has already built them
+  std::string key, path;
+  Ambiguity::AmbigJournal journal;
+  if (graph_cache.length() > 0 && tag_finders.empty()) {
+    key = graph_cache_key(ts);
+    std::ostringstream p;
+    p << graph_cache << "/graphs-" << std::hex << std::setw(16) << std::setfill('0') << std::hash < std::string > () (key) << ".cache";
+    path = p.str();
+    if (load_graphs(path, key, ts)) {
+      std::cerr << "using cached graphs from " << path << std::endl;
+      return;
+    }
+    Ambiguity::journal = & journal;
+  }
+
+  std::map < Nominal_Frequency_kHz, std::vector < Tag * > > activated;
+  for (Ticker look = cron; look.ts() <= ts; /**/) {
+    Event e = look.get();
+    if (e.code == Event::E_ACTIVATE && ! e.tag->active)
+      activated[Freq_Setting::as_Nominal_Frequency_kHz(e.tag->freq)].push_back(e.tag);
+  }
+  for (auto & a : activated)
+    graphs[a.first]->beginBulk(a.second);
+  while (cron.ts() <= ts)
+    process_event(cron.get());
+  for (auto & a : activated)
+    graphs[a.first]->endBulk();
+
+  if (Ambiguity::journal) {
+    Ambiguity::journal = 0;
+    save_graphs(path, key, journal);
+  }
+};
+
+std::string
+Tag_Foray::graph_cache_key(Timestamp ts) {
+  // only the order of the events matters, not their timestamps,
+  // since all are processed before the first pulse
+  std::ostringstream k;
+  k << std::setprecision(17) << SERIALIZATION_VERSION << "," << tags->get_db_hash() << ","
+    << pulse_slop << "," << burst_slop << "," << max_skipped_bursts << "," << timestamp_wonkiness;
+  for (Ticker look = cron; look.ts() <= ts; /**/) {
+    Event e = look.get();
+    k << "," << e.code << ":" << e.tag->motusID;
+  }
+  return k.str();
+};
+
+void
+Tag_Foray::save_graphs(const std::string & path, const std::string & key, const Ambiguity::AmbigJournal & journal) {
+  // every tag is saved first, by value, so that loading can point
+  // the cached graphs at the same tags in that run's Tag_Database.
+  // The file is written under a temporary name, and renamed once
+  // complete, so that runs sharing the cache never see a partial one.
+
+  std::vector < Tag * > all;
+  for (auto f : tags->get_nominal_freqs())
+    for (auto t : * tags->get_tags_at_freq(f))
+      all.push_back(t);
+  std::sort(all.begin(), all.end(), [](Tag * a, Tag * b) {return a->motusID < b->motusID;});
+
+  std::ostringstream tmp;
+  tmp << path << ".tmp" << getpid();
+  std::ofstream ofs(tmp.str(), std::ios::binary);
+  if (ofs) {
+    boost::archive::binary_oarchive oa(ofs);
+    oa << make_nvp("key", key);
+    size_t num_tags = all.size();
+    oa << make_nvp("num_tags", num_tags);
+    for (auto t : all) {
+      const Tag & ct = * t;
+      oa << make_nvp("tag", ct);
+    }
+    oa << make_nvp("abm", Ambiguity::abm);
+    oa << make_nvp("journal", journal);
+    oa << make_nvp("_numNodes", Node::_numNodes);
+    oa << make_nvp("_numLinks", Node::_numLinks);
+    oa << make_nvp("maxLabel", Node::maxLabel);
+    oa << make_nvp("_empty", Node::_empty);
+    oa << make_nvp("_numSets", Set::_numSets);
+    oa << make_nvp("maxLabel", Set::maxLabel);
+    oa << make_nvp("_empty", Set::_empty);
+    oa << make_nvp("graphs", graphs);
+  }
+  ofs.close();
+  if (ofs.fail() || rename(tmp.str().c_str(), path.c_str())) {
+    unlink(tmp.str().c_str());
+    std::cerr << "Warning: unable to write graph cache " << path << std::endl;
+  }
+};
+
+bool
+Tag_Foray::load_graphs(const std::string & path, const std::string & key, Timestamp ts) {
+  // loaded sets are added to the intern table as they are read,
+  // without looking for an equal set already there, and replace the
+  // empty node and set; so nothing but the empty set may exist yet
+  if (! Set::interned.empty()) {
+    std::cerr << "Warning: not using graph cache " << path << ": sets already exist" << std::endl;
+    return false;
+  }
+
+  std::ifstream ifs(path, std::ios::binary);
+  if (! ifs)
+    return false;
+
+  std::vector < std::pair < Tag *, bool > > active;
+  Ambiguity::AmbigBimap abm;
+  Ambiguity::AmbigJournal journal;
+  int numNodes, numLinks, maxNodeLabel, numSets, maxSetLabel;
+  Node * emptyNode;
+  Set * emptySet;
+  std::map < Nominal_Frequency_kHz, Graph * > cached;
+
+  try {
+    boost::archive::binary_iarchive ia(ifs);
+    std::string saved_key;
+    ia >> make_nvp("key", saved_key);
+    if (saved_key != key)
+      return false;
+    size_t num_tags;
+    ia >> make_nvp("num_tags", num_tags);
+    for (size_t i = 0; i < num_tags; ++i) {
+      Tag t;
+      ia >> make_nvp("tag", t);
+      Tag * live = tags->getTagForMotusID(t.motusID);
+      if (! live)
+        throw std::runtime_error("unknown tag");
+      ia.reset_object_address(live, & t);
+      active.push_back(std::make_pair(live, t.active));
+    }
+    ia >> make_nvp("abm", abm);
+    ia >> make_nvp("journal", journal);
+    ia >> make_nvp("_numNodes", numNodes);
+    ia >> make_nvp("_numLinks", numLinks);
+    ia >> make_nvp("maxLabel", maxNodeLabel);
+    ia >> make_nvp("_empty", emptyNode);
+    ia >> make_nvp("_numSets", numSets);
+    ia >> make_nvp("maxLabel", maxSetLabel);
+    ia >> make_nvp("_empty", emptySet);
+    ia >> make_nvp("graphs", cached);
+  } catch (std::exception & e) {
+    std::cerr << "Warning: unable to read graph cache " << path << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  for (auto & a : active)
+    a.first->active = a.second;
+
+  // give proxies the IDs this receiver uses for their tags, replaying
+  // Ambiguity::newProxy for each proxy created while building the
+  // graphs, since those which were later dropped still used up an ID
+  std::map < Motus_Tag_ID, Motus_Tag_ID > proxyID;
+  for (auto & j : journal) {
+    auto i = Ambiguity::ids.left.find(j.first);
+    if (i != Ambiguity::ids.left.end()) {
+      proxyID[j.second] = i->second;
+    } else {
+      proxyID[j.second] = Ambiguity::nextID;
+      Ambiguity::ids.insert(Ambiguity::AmbigIDSetProxy(j.first, Ambiguity::nextID--));
+    }
+  }
+  for (auto i = abm.right.begin(); i != abm.right.end(); ++i)
+    i->first->motusID = proxyID[i->first->motusID];
+  Ambiguity::abm = abm;
+
+  // the graphs built by the constructor are empty, and no Tag_Finder
+  // holds them yet
+  for (auto & g : cached) {
+    delete graphs[g.first];
+    graphs[g.first] = g.second;
+  }
+  Node::_numNodes = numNodes;
+  Node::_numLinks = numLinks;
+  Node::maxLabel = maxNodeLabel;
+  Node::_empty = emptyNode;
+  Set::_numSets = numSets;
+  Set::maxLabel = maxSetLabel;
+  Set::_empty = emptySet;
+
+  while (cron.ts() <= ts)
+    cron.get();
+  return true;
+};
+
 void
 Tag_Foray::test() {
   // try build tag finders for each nominal frequency
@@ -10,6 +10,7 @@
 #include "Data_Source.hpp"
 #include "DB_Filer.hpp"
 #include "Clock_Repair.hpp"
+#include "Record_Cache.hpp"
 
 #include <sqlite3.h>
 #include <boost/serialization/deque.hpp>
@@ -44,6 +45,8 @@ public:
   void start();                 // begin searching for tags
 
   void process_event(Event e);       // !< process a tag add/remove event
+  void process_events(Timestamp ts); // !< process all tag events up to ts, then reclassify each Tag_Finder's candidates once
+  void process_events_in_bulk(Timestamp ts); // !< process all tag events up to ts, adding tags to each graph in one batch
 
   void test();                       // throws an exception if there are indistinguishable tags
   void graph();                      // graph the DFA for each nominal frequency
@@ -63,6 +66,10 @@ public:
 
   static void set_timestamp_wonkiness(unsigned int w);
 
+  void set_record_cache(Record_Cache * rc); //!< write corrected records to rc as they are processed; the foray deletes rc once done
+
+  void set_graph_cache(std::string dir); //!< load the graphs built before the first pulse from folder dir, or build them and save them there
+
   static int num_cands_with_run_id(DB_Filer::Run_ID rid, int delta); //!< return the number of candidates with the given run id
   // if delta is 0. Otherwise, adjust the count by delta, and return the new count.
 
@@ -98,8 +105,12 @@ public:
   //  The serialization version will be (major << 16) | minor
 
   // VERSION 2.0: gzip-compressed
+  // VERSION 3.0: tag candidates share pulse histories
+  // VERSION 4.0: graph nodes have periodic edges
+  // VERSION 5.0: graph node sets are interned and reference-counted
+  // VERSION 6.0: graphs record the range of root edges for each tag
 
-  static constexpr int SERIALIZATION_MAJOR_VERSION = 2;
+  static constexpr int SERIALIZATION_MAJOR_VERSION = 6;
   static constexpr int SERIALIZATION_MINOR_VERSION = 0;
   static constexpr int SERIALIZATION_VERSION = (SERIALIZATION_MAJOR_VERSION << 16) | SERIALIZATION_MINOR_VERSION;
 
@@ -107,6 +118,8 @@ protected:
 
   Data_Source * data;                // stream from which data records are read
   Clock_Repair * cr;                 // filter to fix timestamps in input
+  Record_Cache * cache;              // if not 0, where corrected records are cached for later runs; not serialized
+  std::string graph_cache;           // if not empty, folder where graphs built before the first pulse are cached; not serialized
   Frequency_MHz default_freq;        // default listening frequency on a port where no frequency setting has been seen
   bool force_default_freq;           // ignore in-line frequency settings and always use default?
   float min_dfreq;                   // minimum allowed pulse offset frequency; pulses with smaller offset frequency are
@@ -140,6 +153,20 @@ protected:
 
   Tag_Finder_Map tag_finders;
 
+  // what a pulse on a port needs from port_freq and tag_finders, so
+  // that dispatching it is a couple of loads rather than map lookups;
+  // indexed by port + NUM_SPECIAL_PORTS.  A slot is filled by the first
+  // pulse on its port, and invalidated when the port's frequency is
+  // set.  Not serialized.
+
+  struct Port_Slot {
+    bool valid;           // are the remaining fields current?
+    Frequency_MHz f_MHz;  // port_freq[port].f_MHz
+    Tag_Finder * tf;      // tag_finders[(port, port_freq[port].f_kHz)]; 0 if pulses_only
+  };
+
+  std::vector < Port_Slot > port_slots;
+
   double ts; // for retaining last timestamp
 
   std::map < Nominal_Frequency_kHz, Graph * > graphs;
@@ -189,6 +216,14 @@ protected:
   typedef std::unordered_map < DB_Filer::Run_ID, int > Run_Cand_Counter;
   static  Run_Cand_Counter num_cands_with_run_id_;
 
+  bool edit_graph(Event e, std::pair < Tag *, Tag * > & rv); // apply a tag event to its graph, setting rv to any renaming; false if it changed nothing
+  bool next_record(SG_Record & r);   // get the next corrected record, caching it if required
+  void fill_port_slot(Port_Num port, Port_Slot & ps); // look up port's frequency and Tag_Finder, creating the latter if needed
+  void end_record_cache();           // finish writing the record cache, if any
+  std::string graph_cache_key(Timestamp ts); // what the graphs built by processing tag events up to ts depend on
+  bool load_graphs(const std::string & path, const std::string & key, Timestamp ts); // replace the graphs with those cached in path under key, skipping tag events up to ts; false if none
+  void save_graphs(const std::string & path, const std::string & key, const Ambiguity::AmbigJournal & journal); // cache the graphs in path under key; journal lists the proxies created while building them
+
 #ifdef ACTIVE_TAG_DIAGNOSTICS
   // interval at which active tag list is dumped for each Tag_Finder
   // only used if > 0
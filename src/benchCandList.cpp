@@ -0,0 +1,157 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "Cand_List.hpp"
+
+/*
+  benchCandList: compare Cand_List against the std::multimap it
+  replaced, on a synthetic load resembling what a Tag_Finder sees.
+
+  A fixed population of candidates each waits until its key, then stays
+  ready for SLACK seconds.  Every pulse scans the ready candidates in
+  list order: an expired candidate is replaced by a fresh one, and a
+  live one accepts the pulse with probability ACCEPT, and is
+  re-inserted with a key GAP seconds later.  Gaps are uniform on
+  [MIN_GAP, MAX_GAP].
+
+  Both structures make the same random choices, so if they visit
+  candidates in the same order, they compute the same checksum.
+*/
+
+// stand-in for a Tag_Candidate; the lists only store pointers
+struct Fake_Cand {
+  double expiry;
+  unsigned id;
+};
+
+static const double MIN_GAP = 1.0;
+static const double MAX_GAP = 30.0;
+static const double SLACK = 0.5;
+static const double ACCEPT = 0.2;
+
+static double
+seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration < double > (std::chrono::steady_clock::now() - t0).count();
+};
+
+static Tag_Candidate *
+as_tc(Fake_Cand * f) {
+  return reinterpret_cast < Tag_Candidate * > (f);
+};
+
+static Fake_Cand *
+as_fake(Tag_Candidate * tc) {
+  return reinterpret_cast < Fake_Cand * > (tc);
+};
+
+struct Load {
+  std::mt19937 rng;
+  std::uniform_real_distribution < double > gap;
+  std::uniform_real_distribution < double > coin;
+  unsigned long long checksum;
+  unsigned long long visits;
+
+  Load() : rng(12345), gap(MIN_GAP, MAX_GAP), coin(0, 1), checksum(0), visits(0) {};
+
+  double next_key(Fake_Cand * f, double t) {
+    double k = t + gap(rng);
+    f->expiry = k + SLACK;
+    return k;
+  };
+
+  void visit(Fake_Cand * f) {
+    checksum = checksum * 1000003 + f->id;
+    ++visits;
+  };
+};
+
+static double
+run_multimap(std::vector < Fake_Cand > & cands, int num_pulses, double dt, Load & ld) {
+  typedef std::multimap < Timestamp, Tag_Candidate * > Old_Cand_List;
+  Old_Cand_List cs;
+  for (auto & f : cands)
+    cs.insert(std::make_pair(ld.next_key(& f, 0), as_tc(& f)));
+
+  auto t0 = std::chrono::steady_clock::now();
+  double t = 0;
+  for (int i = 0; i < num_pulses; ++i, t += dt) {
+    Old_Cand_List::iterator nextci;
+    for (auto ci = cs.begin(); ci != cs.end() && t >= ci->first; ci = nextci) {
+      nextci = ci;
+      ++nextci;
+      Fake_Cand * f = as_fake(ci->second);
+      ld.visit(f);
+      if (t > f->expiry || ld.coin(ld.rng) < ACCEPT) {
+        cs.erase(ci);
+        cs.insert(std::make_pair(ld.next_key(f, t), as_tc(f)));
+      }
+    }
+  }
+  return seconds_since(t0);
+};
+
+static double
+run_cand_list(std::vector < Fake_Cand > & cands, int num_pulses, double dt, Load & ld) {
+  Cand_List cs;
+  for (auto & f : cands)
+    cs.insert(ld.next_key(& f, 0), as_tc(& f));
+
+  auto t0 = std::chrono::steady_clock::now();
+  double t = 0;
+  for (int i = 0; i < num_pulses; ++i, t += dt) {
+    cs.advance(t);
+    for (size_t k = 0; k < cs.num_ready() && t >= cs.ready_at(k).key; ++k) {
+      Tag_Candidate * tc = cs.ready_at(k).tc;
+      if (! tc)
+        continue;
+      Fake_Cand * f = as_fake(tc);
+      ld.visit(f);
+      if (t > f->expiry || ld.coin(ld.rng) < ACCEPT) {
+        cs.remove_ready(k);
+        cs.insert(ld.next_key(f, t), tc);
+      }
+    }
+    cs.compact();
+  }
+  return seconds_since(t0);
+};
+
+int main (int argc, char * argv[] ) {
+  if (argc > 1 && std::string(argv[1]) == "-h") {
+    std::cout << "\
+Usage:\n\
+    benchCandList [NUM_CANDS [NUM_PULSES [PULSE_INTERVAL]]]\n\
+\n\
+Time NUM_CANDS (default: 100000) live tag candidates through NUM_PULSES\n\
+(default: 20000) pulses spaced PULSE_INTERVAL (default: 0.001) seconds\n\
+apart, first in a std::multimap, then in a Cand_List, and check that\n\
+both visit candidates in the same order.\n\
+";
+    exit(0);
+  }
+
+  int num_cands = argc > 1 ? atoi(argv[1]) : 100000;
+  int num_pulses = argc > 2 ? atoi(argv[2]) : 20000;
+  double dt = argc > 3 ? atof(argv[3]) : 0.001;
+
+  std::vector < Fake_Cand > cands(num_cands);
+  for (int i = 0; i < num_cands; ++i)
+    cands[i].id = i;
+
+  Load ld[2];
+  double elapsed[2];
+  elapsed[0] = run_multimap(cands, num_pulses, dt, ld[0]);
+  elapsed[1] = run_cand_list(cands, num_pulses, dt, ld[1]);
+
+  bool same = ld[0].checksum == ld[1].checksum && ld[0].visits == ld[1].visits;
+  std::cout << num_cands << " candidates, " << num_pulses << " pulses, " << ld[1].visits << " visits" << std::endl;
+  std::cout << "std::multimap: " << elapsed[0] << " s" << std::endl;
+  std::cout << "Cand_List:     " << elapsed[1] << " s" << std::endl;
+  std::cout << "speedup:       " << elapsed[0] / elapsed[1] << std::endl;
+  std::cout << (same ? "same order" : "DIFFERENT ORDER") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+#include "Graph.hpp"
+
+/*
+  benchGraph: time Node::advance on a DFA graph for a Motus-sized set
+  of synthetic tags, comparing the flattened edge table against a
+  lookup in the std::map of edges it is compiled from, and against
+  Graph_Table::advance, which walks state IDs rather than Nodes.
+
+  Tags resemble Lotek coded IDs: three intra-burst gaps, each a
+  multiple of 5 ms between 20 ms and 200 ms, and a burst interval
+  between 2 and 30 s.  Queries come from walks which follow a random
+  tag's gaps from a random phase, with up to 1 ms of jitter, and
+  which sometimes take a random gap instead, as noise pulses would.
+
+  All lookups see the same queries, so if they agree, they compute
+  the same checksum.
+
+  The graph is also built a second time, with the tags added in bulk
+  as Tag_Foray does at startup, which should give a graph of the
+  same size.
+*/
+
+static const Gap MIN_GAP = 0.020;
+static const Gap GAP_STEP = 0.005;
+static const int NUM_GAP_STEPS = 37;
+static const Gap MIN_BI = 2.0;
+static const Gap MAX_BI = 30.0;
+static const double TOL = 0.0015;
+static const double JITTER = 0.001;
+static const double NOISE = 0.1;
+
+static double
+seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration < double > (std::chrono::steady_clock::now() - t0).count();
+};
+
+static Node *
+map_advance(Node * n, Gap dt) {
+  auto i = n->edges().upper_bound(dt);
+  --i;
+  if (i->second != Node::empty())
+    return i->second;
+  for (auto & p : n->periodic_edges())
+    if (p.match(dt))
+      return p.target != Node::empty() ? p.target : 0;
+  return 0;
+};
+
+int main (int argc, char * argv[] ) {
+  if (argc > 1 && std::string(argv[1]) == "-h") {
+    std::cout << "\
+Usage:\n\
+    benchGraph [NUM_TAGS [NUM_QUERIES]]\n\
+\n\
+Build a DFA graph for NUM_TAGS (default: 1000) synthetic tags, then time\n\
+NUM_QUERIES (default: 10000000) calls to Node::advance, first by looking\n\
+up the std::map of edges, then by searching the flattened edge table,\n\
+then by walking the graph's compiled Graph_Table, and check that all\n\
+give the same nodes.  Also time building the graph again with the tags\n\
+added in bulk, and check it has the same size.\n\
+";
+    exit(0);
+  }
+
+  int num_tags = argc > 1 ? atoi(argv[1]) : 1000;
+  long num_queries = argc > 2 ? atol(argv[2]) : 10000000;
+
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution < int > step(0, NUM_GAP_STEPS - 1);
+  std::uniform_real_distribution < double > bi(MIN_BI, MAX_BI);
+  std::uniform_real_distribution < double > jitter(-JITTER, JITTER);
+  std::uniform_real_distribution < double > coin(0, 1);
+
+  Node::init();
+  Graph g("benchGraph");
+
+  std::vector < Tag * > tags;
+  std::set < std::vector < int > > codes;
+  int nodes0 = Node::numNodes(), links0 = Node::numLinks();
+  auto t0 = std::chrono::steady_clock::now();
+  while ((int) tags.size() < num_tags) {
+    std::vector < int > code = {step(rng), step(rng), step(rng)};
+    if (! codes.insert(code).second)
+      continue;
+    std::vector < Gap > gaps;
+    for (auto c : code)
+      gaps.push_back(MIN_GAP + c * GAP_STEP);
+    gaps.push_back(bi(rng));
+    Tag * t = new Tag(tags.size() + 1, 166.38, 4, 0, 0, gaps);
+    g.addTag(t, TOL, 0, 30, 0);
+    t->active = true;
+    tags.push_back(t);
+  }
+  double build = seconds_since(t0);
+  int num_nodes = Node::numNodes() - nodes0, num_links = Node::numLinks() - links0;
+
+  Graph bg("benchGraph");
+  nodes0 = Node::numNodes();
+  links0 = Node::numLinks();
+  t0 = std::chrono::steady_clock::now();
+  bg.beginBulk(tags);
+  for (auto t : tags)
+    bg.addTag(t, TOL, 0, 30, 0);
+  bg.endBulk();
+  double bulk_build = seconds_since(t0);
+  bool same_size = Node::numNodes() - nodes0 == num_nodes && Node::numLinks() - links0 == num_links;
+  if (! same_size)
+    std::cout << "bulk graph has " << Node::numNodes() - nodes0 << " nodes, " << Node::numLinks() - links0 << " edges" << std::endl;
+
+  // walk the graph to generate queries
+  std::vector < std::pair < Node *, Gap > > queries;
+  queries.reserve(num_queries);
+  std::uniform_int_distribution < int > pick(0, num_tags - 1);
+  std::uniform_int_distribution < int > phase(0, 3);
+  std::uniform_real_distribution < double > noise(0, MAX_BI);
+  while ((long) queries.size() < num_queries) {
+    Tag * t = tags[pick(rng)];
+    int j = phase(rng);
+    for (Node * n = g.root(); n && (long) queries.size() < num_queries; j = (j + 1) % 4) {
+      Gap dt = coin(rng) < NOISE ? noise(rng) : t->gaps[j] + jitter(rng);
+      queries.push_back(std::make_pair(n, dt));
+      n = n->advance(dt);
+    }
+  }
+
+  // the table only sees state IDs, and compiles states as they are
+  // reached, so warm it up with the same queries
+  Graph_Table & table = g.get_table();
+  std::vector < std::pair < Graph_Table::State_ID, Gap > > table_queries;
+  table_queries.reserve(num_queries);
+  for (auto & q : queries) {
+    auto s = table.id_of(q.first);
+    table.advance(s, q.second);
+    table_queries.push_back(std::make_pair(s, q.second));
+  }
+
+  unsigned long long sum[3] = {0, 0, 0};
+  double elapsed[3];
+
+  t0 = std::chrono::steady_clock::now();
+  for (auto & q : queries)
+    sum[0] = sum[0] * 31 + (size_t) map_advance(q.first, q.second);
+  elapsed[0] = seconds_since(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  for (auto & q : queries)
+    sum[1] = sum[1] * 31 + (size_t) q.first->advance(q.second);
+  elapsed[1] = seconds_since(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  for (auto & q : table_queries) {
+    auto s = table.advance(q.first, q.second);
+    sum[2] = sum[2] * 31 + (size_t) (s != Graph_Table::NO_STATE ? table.state(s).node : 0);
+  }
+  elapsed[2] = seconds_since(t0);
+
+  std::cout << num_tags << " tags, " << num_nodes << " nodes, " << num_links << " edges; built in " << build << " s" << std::endl;
+  std::cout << "bulk build: " << bulk_build << " s" << (same_size ? "" : " (DIFFERENT SIZE)") << std::endl;
+  std::cout << queries.size() << " queries" << std::endl;
+  std::cout << "std::map:   " << queries.size() / elapsed[0] / 1e6 << " M advances/s" << std::endl;
+  std::cout << "flattened:  " << queries.size() / elapsed[1] / 1e6 << " M advances/s" << std::endl;
+  std::cout << "table:      " << queries.size() / elapsed[2] / 1e6 << " M advances/s" << std::endl;
+  std::cout << "speedup:    " << elapsed[0] / elapsed[1] << " (flattened), " << elapsed[0] / elapsed[2] << " (table)" << std::endl;
+  bool same = sum[0] == sum[1] && sum[0] == sum[2] && same_size;
+  std::cout << (same ? "same nodes" : "DIFFERENT NODES") << std::endl;
+  return same ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SG_Record.hpp"
+
+/*
+  benchSGRecord: compare SG_Record::from_buf against the sscanf-based
+  reference parser SG_Record::from_buf_sscanf on recorded raw SG data.
+
+  Every line is parsed by both, and the resulting records are compared
+  bit-for-bit; then each parser is timed over the whole set of lines.
+*/
+
+static bool
+same_bits(const void * a, const void * b, size_t n) {
+  return ! memcmp(a, b, n);
+};
+
+static bool
+same_record(const SG_Record & a, const SG_Record & b) {
+  if (a.type != b.type)
+    return false;
+  switch (a.type) {
+  case SG_Record::PULSE:
+    return a.port == b.port && same_bits(& a.ts, & b.ts, sizeof(a.ts))
+      && same_bits(& a.v.dfreq, & b.v.dfreq, sizeof(a.v.dfreq))
+      && same_bits(& a.v.sig, & b.v.sig, sizeof(a.v.sig))
+      && same_bits(& a.v.noise, & b.v.noise, sizeof(a.v.noise));
+  case SG_Record::GPS:
+    return same_bits(& a.ts, & b.ts, sizeof(a.ts))
+      && same_bits(& a.v.lat, & b.v.lat, sizeof(a.v.lat))
+      && same_bits(& a.v.lon, & b.v.lon, sizeof(a.v.lon))
+      && same_bits(& a.v.alt, & b.v.alt, sizeof(a.v.alt));
+  case SG_Record::PARAM:
+    return a.port == b.port && same_bits(& a.ts, & b.ts, sizeof(a.ts))
+      && ! strcmp(a.v.param_flag, b.v.param_flag)
+      && same_bits(& a.v.param_value, & b.v.param_value, sizeof(a.v.param_value))
+      && a.v.return_code == b.v.return_code
+      && ! strcmp(a.v.error, b.v.error);
+  case SG_Record::CLOCK:
+    return same_bits(& a.ts, & b.ts, sizeof(a.ts))
+      && a.v.clock_level == b.v.clock_level
+      && same_bits(& a.v.clock_remaining, & b.v.clock_remaining, sizeof(a.v.clock_remaining));
+  case SG_Record::FILE:
+    return same_bits(& a.ts, & b.ts, sizeof(a.ts));
+  default:
+    return true;
+  }
+};
+
+static double
+seconds_since(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration < double > (std::chrono::steady_clock::now() - t0).count();
+};
+
+static void
+usage() {
+  std::cout << "\
+Usage:\n\
+    benchSGRecord [-n REPS] FILE...\n\
+\n\
+Parse each line of the uncompressed raw SG files FILE... with both\n\
+SG_Record::from_buf and the sscanf-based parser SG_Record::from_buf_sscanf,\n\
+report any line on which the two disagree, then time REPS passes\n\
+(default: 5) of each parser over all lines.\n\
+";
+};
+
+int main (int argc, char * argv[] ) {
+  if (argc > 1 && std::string(argv[1]) == "-h") {
+    usage();
+    exit(0);
+  }
+
+  int i = 1;
+  int reps = 5;
+  if (argc > i + 1 && std::string(argv[i]) == "-n") {
+    reps = atoi(argv[i + 1]);
+    i += 2;
+  }
+  if (i == argc) {
+    // timings over no lines mean nothing
+    usage();
+    exit(1);
+  }
+
+  std::vector < std::string > lines;
+  std::string line;
+  for (; i < argc; ++i) {
+    std::ifstream inf(argv[i]);
+    if (! inf)
+      throw std::runtime_error(std::string("Unable to open file ") + argv[i]);
+    while (std::getline(inf, line))
+      lines.push_back(line);
+  }
+  for (auto & l : lines)
+    if (l.size() > MAX_LINE_SIZE)
+      l.resize(MAX_LINE_SIZE);
+
+  std::cout << "Read " << lines.size() << " lines" << std::endl;
+
+  // correctness
+
+  unsigned long long mismatches = 0;
+  unsigned long long counts[SG_Record::FILE + 1] = {0};
+  std::vector < char > buf(MAX_LINE_SIZE + 1);
+  for (auto & l : lines) {
+    SG_Record a, b;
+    strcpy(& buf[0], l.c_str());
+    a.from_buf(& buf[0]);
+    strcpy(& buf[0], l.c_str());
+    b.from_buf_sscanf(& buf[0]);
+    ++counts[b.type];
+    if (! same_record(a, b)) {
+      if (++mismatches <= 10)
+        std::cout << "Mismatch on line: " << l << std::endl;
+    }
+  }
+  static const char * type_names[] = {"bad", "pulse", "GPS", "param", "clock", "extension", "file"};
+  for (int t = 0; t <= SG_Record::FILE; ++t)
+    if (counts[t])
+      std::cout << "   " << counts[t] << " " << type_names[t] << " records" << std::endl;
+  std::cout << mismatches << " mismatches" << std::endl;
+
+  // speed
+
+  SG_Record r;
+  double elapsed[2];
+  for (int which = 0; which < 2; ++which) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < reps; ++k) {
+      for (auto & l : lines) {
+        if (which == 0)
+          r.from_buf(& l[0]);
+        else
+          r.from_buf_sscanf(& l[0]);
+      }
+    }
+    elapsed[which] = seconds_since(t0);
+  }
+  double n = (double) lines.size() * reps;
+  std::cout << "from_buf:        " << n / elapsed[0] / 1e6 << " M lines/s" << std::endl;
+  std::cout << "from_buf_sscanf: " << n / elapsed[1] / 1e6 << " M lines/s" << std::endl;
+  std::cout << "speedup:         " << elapsed[1] / elapsed[0] << std::endl;
+
+  return mismatches ? 1 : 0;
+}
@@ -238,6 +238,9 @@ main (int argc, char **argv) {
 
   std::string input_file;
   bool src_sqlite;
+  int prefetch_files;
+  std::string record_cache;
+  std::string graph_cache;
   bool lotek;
   std::string tag_database;
   bool use_events;
@@ -335,14 +338,37 @@ main (int argc, char **argv) {
     ("input_file", po::value< std::string >(&input_file)->default_value(""),
      "if `src_sqlite` is specified, this is a `.sqlite` database which contains "
      "table `files` (for sensorgnomes) or table `DTAtags` (for Lotek receivers).  "
-     "Otherwise, it is a .csv file, defaulting to `stdin` if not specified.  "
-     "Raw receiver records are read from the specified file."
+     "Otherwise, it is a raw receiver file (compressed if its name ends in `.gz`), "
+     "or a directory which is searched for files named like `*.txt` and `*.txt.gz`, "
+     "or `@FILE` where FILE lists such files and directories, one per line.  "
+     "Files are read in order of the timestamp in their names.  "
+     "Raw receiver records are read from `stdin` if this is not specified."
      )
     ("src_sqlite,Q", po::value<bool>(& src_sqlite)->implicit_value(true)->default_value(false),
      "Treat `input_file` as an sqlite database and fetch paths to compressed data files "
      "from the `files` table if a sensorgnome, or from the `DTAtags` table if a Lotek "
      "receiver."
      )
+    ("prefetch_files", po::value<int>(& prefetch_files)->default_value(2),
+     "With `src_sqlite`, the number of receiver files to read and decompress ahead, "
+     "on worker threads, while tags are being found in earlier files.  "
+     "0 means read each file only when it is needed."
+     )
+    ("record_cache", po::value< std::string >(& record_cache)->default_value(""),
+     "With `src_sqlite`, a folder in which to cache the clock-corrected records "
+     "of each boot session, in a file named after `output_db` and `bootnum`.  "
+     "When the boot session is processed from its start, and the cache is present "
+     "and its files have not changed since it was written, records are read from "
+     "the cache instead of from the raw files, and clock repair is skipped.  "
+     "Otherwise, the cache is (re-)written.  The cache is not used when resuming."
+     )
+    ("graph_cache", po::value< std::string >(& graph_cache)->default_value(""),
+     "A folder in which to cache the graphs built from the tags deployed at the first pulse.  "
+     "The cache is keyed by the tag database's hash, `pulse_slop`, `burst_slop`, "
+     "`max_skipped_bursts`, `timestamp_wonkiness` and the tag events before the first pulse, "
+     "so that runs on other receivers or boot sessions which would build the same graphs "
+     "load them instead.  The cache is not used when resuming."
+     )
     ("lotek,L", po::value<bool>(& lotek)->implicit_value(true)->default_value(false),
      "Indicates that input data come from a lotek receiver.  In this case, input lines "
      "have a different format: TS,ID,ANT,SIG,ANTFREQ,GAIN,CODESET with:\n"
@@ -524,6 +550,9 @@ main (int argc, char **argv) {
   if (resume && lotek) {
     throw std::runtime_error("Can't use --resume with a Lotek receiver");
   };
+  if (record_cache.length() > 0 && (lotek || ! src_sqlite)) {
+    throw std::runtime_error("--record_cache can only be used with --src_sqlite for a sensorgnome");
+  }
   if (timestamp_wonkiness > 0 && ! lotek) {
     throw std::runtime_error("must specify --lotek in order to use --timestamp_wonkiness=N with N > 0");
   }
@@ -605,9 +634,10 @@ main (int argc, char **argv) {
           throw std::runtime_error("Must specify --src_sqlite with a Lotek data source");
         }
       } else if (src_sqlite) {
+        dbf.set_blob_prefetch(prefetch_files);
         pulses = Data_Source::make_SQLite_source(& dbf, bootnum);
       } else {
-        pulses = Data_Source::make_SG_source(optind < argc ? argv[optind++] : "");
+        pulses = Data_Source::make_SG_source(input_file);
       }
 
       Tag_Foray foray;
@@ -631,7 +661,24 @@ main (int argc, char **argv) {
         // Freq_Setting needs to know the set of nominal frequencies
         Freq_Setting::set_nominal_freqs(tag_db->get_nominal_freqs());
 
+        // use cached records if they're still good; otherwise cache them for next time
+        Record_Cache * cache = 0;
+        if (record_cache.length() > 0 && ! (graph_only || test_only)) {
+          std::string cache_path = Record_Cache::path_for(record_cache, output_db, bootnum);
+          Data_Source * cached = Data_Source::make_Record_Cache_source(& dbf, bootnum, cache_path);
+          if (cached) {
+            delete pulses;
+            pulses = cached;
+            std::cerr << "using cached records from " << cache_path << std::endl;
+          } else {
+            cache = new Record_Cache(cache_path, bootnum, dbf.get_file_set(bootnum));
+          }
+        }
+
         foray = Tag_Foray(tag_db, pulses, default_freq, force_default_freq, min_dfreq, max_dfreq, max_pulse_rate, pulse_rate_window, min_bogus_spacing, unsigned_dfreq, pulses_only);
+        foray.set_record_cache(cache);
+        if (graph_cache.length() > 0 && ! (graph_only || test_only))
+          foray.set_graph_cache(graph_cache);
       }
 
       // record the commit hash from the meta database as an external parameter
@@ -680,6 +727,7 @@ main (int argc, char **argv) {
       }
       foray.start();
       std::cerr << "Max num candidates: " << Tag_Candidate::get_max_num_cands() << " at " << std::setprecision(14) << Tag_Candidate::get_max_cand_time() << "; now (" << foray.last_seen() << "): " << Tag_Candidate::get_num_cands() << std::endl;
+      std::cerr << "Max num " << Slab_Pool::SLAB_BYTES / 1024 << "k slabs for candidates and pulses: " << Slab_Pool::get_max_total_slabs() << "; now: " << Slab_Pool::get_total_slabs() << std::endl;
       foray.pause();
     }
     catch (std::runtime_error& e) {
@@ -0,0 +1,51 @@
+#!/bin/bash
+
+## This tests two tag finders walking the same graph: tag 10695 is
+## heard on port 2 for 12 bursts, and on port 1 only for the last 2,
+## so when the run ends, port 1 still has unconfirmed candidates
+## sitting on nodes shared with port 2's confirmed candidate.
+## Deleting the finders must not touch candidates already freed.
+
+## Relative paths assume this script is run from its directory.
+
+SQL=sqlite3
+TAGDB=test1/test1.sqlite
+RCVDB=test2.sqlite
+PULSES=test2.txt
+FINDTAGS="valgrind --track-origins=yes --error-exitcode=3 ../src/find_tags_motus"
+OPTIONS="--default_freq=166.376 --pulses_to_confirm=10"
+
+tar -xjvf test1.tar.bz2 $TAGDB
+cp $TAGDB $RCVDB
+
+## bursts of tag 10695: period 19.9942 s; gaps 22.04, 19.65, 24.44 ms
+awk 'BEGIN {
+  g[0] = 0; g[1] = 0.0220405; g[2] = g[1] + 0.0196465; g[3] = g[2] + 0.0244360;
+  for (b = 0; b < 12; ++b) {
+    for (k = 0; k < 4; ++k) {
+      ts = 1504282000 + b * 19.9942 + g[k];
+      printf "p2,%.4f,4.35,-60,-80\n", ts;
+      if (b >= 10)
+        printf "p1,%.4f,4.35,-60,-80\n", ts;
+    }
+  }
+}' > $PULSES
+
+$FINDTAGS $OPTIONS $TAGDB $RCVDB $PULSES
+RC=$?
+
+$SQL $RCVDB <<EOF
+select "two finders exit cleanly: " ||
+   case when $RC = 0
+   then "PASS"
+   else "FAIL"
+   end;
+
+select "one run on port 2 only: " ||
+   case when
+       (select count(*) from runs where ant=2 and len=12) = 1
+       and (select count(*) from runs) = 1
+   then "PASS"
+   else "FAIL"
+   end;
+EOF